@@ -34,6 +34,7 @@ public class FinePlay : ModuleRules
 				"EnhancedInput", 
 				"Niagara",
 				"AIModule",
+				"NavigationSystem",
 				"GameplayAbilities",
 				"GameplayTasks",
 				"Paper2D",
@@ -49,6 +50,7 @@ public class FinePlay : ModuleRules
 				"Engine",
 				"Slate",
 				"SlateCore", 
+				"Json",
 				// ... add private dependencies that you statically link with here ...	
 			}
 		);
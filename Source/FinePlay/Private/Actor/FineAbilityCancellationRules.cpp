@@ -0,0 +1,92 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Actor/FineAbilityCancellationRules.h"
+
+#include "AbilitySystemComponent.h"
+#include "Actor/FineAbilityRegistry.h"
+
+int32 FFineAbilityCancellationRules::Add(const FFineAbilityCancellationRule& Rule)
+{
+	auto& CompiledRule = Rules.AddDefaulted_GetRef();
+	CompiledRule.ID = NextID++;
+	CompiledRule.Rule = Rule;
+	return CompiledRule.ID;
+}
+
+bool FFineAbilityCancellationRules::Remove(int32 RuleID)
+{
+	return Rules.RemoveAll([RuleID](const FCompiledRule& CompiledRule)
+	{
+		return CompiledRule.ID == RuleID;
+	}) > 0;
+}
+
+void FFineAbilityCancellationRules::Reset()
+{
+	Rules.Reset();
+}
+
+void FFineAbilityCancellationRules::Compile(UAbilitySystemComponent* AbilitySystem,
+                                            const FFineAbilityRegistry& Registry)
+{
+	for (auto& CompiledRule : Rules)
+	{
+		CompileRule(CompiledRule, AbilitySystem, Registry);
+	}
+}
+
+void FFineAbilityCancellationRules::GetAttributes(TArray<FGameplayAttribute>& OutAttributes) const
+{
+	for (const auto& CompiledRule : Rules)
+	{
+		if (CompiledRule.Rule.Attribute.IsValid())
+		{
+			OutAttributes.AddUnique(CompiledRule.Rule.Attribute);
+		}
+	}
+}
+
+void FFineAbilityCancellationRules::Evaluate(UAbilitySystemComponent* AbilitySystem,
+                                             const FGameplayAttribute& Attribute, float NewValue) const
+{
+	for (const auto& CompiledRule : Rules)
+	{
+		if (NewValue > CompiledRule.Rule.Threshold || CompiledRule.Rule.Attribute != Attribute)
+		{
+			continue;
+		}
+		for (const auto& Handle : CompiledRule.Handles)
+		{
+			AbilitySystem->CancelAbilityHandle(Handle);
+		}
+	}
+}
+
+void FFineAbilityCancellationRules::CompileRule(FCompiledRule& CompiledRule, UAbilitySystemComponent* AbilitySystem,
+                                                const FFineAbilityRegistry& Registry) const
+{
+	CompiledRule.Handles.Reset();
+	const auto& Rule = CompiledRule.Rule;
+	if (Rule.CancelInputID != INDEX_NONE)
+	{
+		if (const auto Handles = Registry.FindByInputID(Rule.CancelInputID))
+		{
+			CompiledRule.Handles.Append(*Handles);
+		}
+	}
+	if (!Rule.CancelAbilitiesWithTags.IsEmpty() && IsValid(AbilitySystem))
+	{
+		// Scans the ability list, but only when abilities change.
+		TArray<FGameplayAbilitySpec*> Specs;
+		for (const auto& Tag : Rule.CancelAbilitiesWithTags)
+		{
+			AbilitySystem->GetActivatableGameplayAbilitySpecsByAllMatchingTags(FGameplayTagContainer(Tag), Specs,
+			                                                                     false);
+		}
+		for (const auto Spec : Specs)
+		{
+			CompiledRule.Handles.AddUnique(Spec->Handle);
+		}
+	}
+}
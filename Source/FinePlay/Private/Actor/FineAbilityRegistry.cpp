@@ -0,0 +1,77 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Actor/FineAbilityRegistry.h"
+
+#include "Algo/SortBy.h"
+
+void FFineAbilityRegistry::Add(const FGameplayAbilitySpecHandle& Handle, const UClass* AbilityClass, int32 InputID,
+                               const UObject* SourceObject)
+{
+	if (!Handle.IsValid() || Entries.Contains(Handle))
+	{
+		return;
+	}
+	auto& Entry = Entries.Add(Handle);
+	Entry.Handle = Handle;
+	Entry.AbilityClass = AbilityClass;
+	Entry.InputID = InputID;
+	Entry.SourceObject = FObjectKey(SourceObject);
+	Entry.GrantOrder = NextGrantOrder++;
+
+	ByClass.FindOrAdd(AbilityClass).Add(Handle);
+	ByInputID.FindOrAdd(InputID).Add(Handle);
+	BySourceObject.FindOrAdd(Entry.SourceObject).Add(Handle);
+}
+
+bool FFineAbilityRegistry::Remove(const FGameplayAbilitySpecHandle& Handle)
+{
+	FFineAbilityRegistryEntry Entry;
+	if (!Entries.RemoveAndCopyValue(Handle, Entry))
+	{
+		return false;
+	}
+	RemoveFromIndex(ByClass, Entry.AbilityClass, Handle);
+	RemoveFromIndex(ByInputID, Entry.InputID, Handle);
+	RemoveFromIndex(BySourceObject, Entry.SourceObject, Handle);
+	return true;
+}
+
+void FFineAbilityRegistry::Reset()
+{
+	Entries.Reset();
+	ByClass.Reset();
+	ByInputID.Reset();
+	BySourceObject.Reset();
+}
+
+void FFineAbilityRegistry::FindByClassOrSubclass(const UClass* AbilityClass,
+                                                 TArray<FGameplayAbilitySpecHandle>& OutHandles) const
+{
+	// Walks distinct classes only, not granted abilities.
+	const auto FirstIndex = OutHandles.Num();
+	int32 MatchingClasses = 0;
+	for (const auto& Pair : ByClass)
+	{
+		if (Pair.Key && Pair.Key->IsChildOf(AbilityClass))
+		{
+			OutHandles.Append(Pair.Value);
+			++MatchingClasses;
+		}
+	}
+	// Each class keeps grant order, but the classes come in hash order.
+	if (MatchingClasses > 1)
+	{
+		Algo::SortBy(MakeArrayView(OutHandles).Slice(FirstIndex, OutHandles.Num() - FirstIndex),
+		             [this](const FGameplayAbilitySpecHandle& Handle) { return Entries[Handle].GrantOrder; });
+	}
+}
+
+void FFineAbilityRegistry::GetHandles(TArray<FGameplayAbilitySpecHandle>& OutHandles) const
+{
+	OutHandles.Reserve(OutHandles.Num() + Entries.Num());
+	for (const auto& Pair : Entries)
+	{
+		OutHandles.Add(Pair.Key);
+	}
+}
@@ -0,0 +1,114 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Actor/FineActorArchetype.h"
+
+#include "FinePlayLog.h"
+#include "Abilities/GameplayAbility.h"
+#include "Data/FineDatabaseRecord.h"
+#include "Data/FineLocalDatabaseComponent.h"
+#include "Engine/World.h"
+#include "Diagnostics/FinePlayStats.h"
+
+void UFineActorArchetype::LoadDisplayData(UFineLocalDatabaseComponent* Database)
+{
+	FP_SCOPE_CALL(DatabaseLookup);
+	bool bSuccess = false;
+	const auto Record = Database->GetRecordByName(TEXT("DisplayData"), ActorName, bSuccess);
+	if (bSuccess)
+	{
+		DisplayData.UpdateFromRecord(Record);
+	}
+}
+
+void UFineActorArchetype::LoadCharacterData(UFineLocalDatabaseComponent* Database)
+{
+	FP_SCOPE_CYCLE(DatabaseLookup);
+	bHasCharacterData = true;
+
+	// Base attributes.
+	bool bSuccess = false;
+	INC_DWORD_STAT(STAT_FinePlay_DatabaseLookupCalls);
+	const auto Record = Database->GetRecordByName(TEXT("CharacterAttributeSet"), ActorName, bSuccess);
+	if (bSuccess)
+	{
+		AttributeData.Health = Record.FloatFields[TEXT("Health")];
+		AttributeData.Mana = Record.FloatFields[TEXT("Mana")];
+		AttributeData.MovementSpeed = Record.FloatFields[TEXT("MovementSpeed")];
+		AttributeData.AttackPower = Record.FloatFields[TEXT("AttackPower")];
+		AttributeData.DefensePower = Record.FloatFields[TEXT("DefensePower")];
+		AttributeData.Stamina = Record.FloatFields[TEXT("Stamina")];
+		bHasAttributeData = true;
+	}
+
+	// Fetch the list of records from "GameplayAbility" entity for the current actor.
+	INC_DWORD_STAT(STAT_FinePlay_DatabaseLookupCalls);
+	const auto Records = Database->FilterRecords(
+		TEXT("GameplayAbility"), FString::Printf(TEXT("Name = '%s'"), *ActorName.ToString()), bSuccess);
+	if (!bSuccess)
+	{
+		FP_LOG("GameplayAbility fetch failed.");
+		return;
+	}
+	INC_DWORD_STAT_BY(STAT_FinePlay_DatabaseLookupCalls, Records.Num());
+	for (const auto& AbilityListRecord : Records)
+	{
+		const auto AbilityName = AbilityListRecord.StringFields.FindChecked(TEXT("AbilityName"));
+		const auto AbilityRecord = Database->GetRecordByName(TEXT("AbilityData"), *AbilityName, bSuccess);
+		if (!bSuccess) continue;
+		const auto AbilityClassPath = AbilityRecord.StringFields[TEXT("AbilityClass")];
+		// Turn AbilityClassPath into TSubclass<UGameplayAbility>.
+		const FSoftClassPath SoftClassPath(AbilityClassPath);
+		const auto AbilityClass = SoftClassPath.TryLoadClass<UGameplayAbility>();
+		if (!IsValid(AbilityClass))
+		{
+			FP_ERROR("Invalid ability class path: %s", *AbilityClassPath);
+			continue;
+		}
+		FFineAbilityArchetypeData& Ability = Abilities.AddDefaulted_GetRef();
+		Ability.AbilityClass = AbilityClass;
+		Ability.Level = AbilityRecord.IntFields[TEXT("Level")];
+		Ability.InputID = AbilityRecord.IntFields[TEXT("InputID")];
+	}
+}
+
+UFineActorArchetype* UFineActorArchetypeSubsystem::FindOrLoadArchetype(const FName& ActorName,
+                                                                       UFineLocalDatabaseComponent* Database,
+                                                                       bool bIncludeCharacterData)
+{
+	auto& Archetype = Archetypes.FindOrAdd(ActorName);
+	if (!IsValid(Archetype))
+	{
+		if (!IsValid(Database))
+		{
+			Archetypes.Remove(ActorName);
+			return nullptr;
+		}
+		Archetype = NewObject<UFineActorArchetype>(this);
+		Archetype->ActorName = ActorName;
+		Archetype->LoadDisplayData(Database);
+		FP_VERBOSE("Archetype created: %s", *ActorName.ToString());
+	}
+	if (bIncludeCharacterData && !Archetype->HasCharacterData() && IsValid(Database))
+	{
+		Archetype->LoadCharacterData(Database);
+	}
+	return Archetype;
+}
+
+void UFineActorArchetypeSubsystem::ResetArchetypes()
+{
+	Archetypes.Empty();
+}
+
+UFineActorArchetypeSubsystem* UFineActorArchetypeSubsystem::Get(const UObject* WorldContextObject)
+{
+	const auto World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return IsValid(World) ? World->GetSubsystem<UFineActorArchetypeSubsystem>() : nullptr;
+}
+
+void UFineActorArchetypeSubsystem::Deinitialize()
+{
+	Archetypes.Empty();
+	Super::Deinitialize();
+}
@@ -3,7 +3,7 @@
 
 #include "Actor/FineActorGameplay.h"
 
-#include "Data/FineDatabaseRecord.h"
+#include "Actor/FineActorArchetype.h"
 #include "Data/FineLocalDatabaseComponent.h"
 #include "GameFramework/GameStateBase.h"
 #include "Kismet/GameplayStatics.h"
@@ -18,19 +18,25 @@ void UFineActorGameplay::BeginPlay()
 	LocalDatabaseComponent = GameState->FindComponentByClass<UFineLocalDatabaseComponent>();
 	if (ensure(IsValid(LocalDatabaseComponent)))
 	{
-		// database record from local database component
-		bool bSuccess = false;
-		const auto Record = LocalDatabaseComponent->GetRecordByName(TEXT("DisplayData"), ActorName, bSuccess);
-		if (bSuccess)
+		// Share the archetype with all actors of the same name instead of copying the records.
+		const auto Archetypes = UFineActorArchetypeSubsystem::Get(this);
+		if (ensure(IsValid(Archetypes)))
 		{
-			DisplayData.UpdateFromRecord(Record);
+			Archetype = Archetypes->FindOrLoadArchetype(ActorName, LocalDatabaseComponent, NeedsCharacterArchetype());
 		}
 	}
 }
 
+const FFineDisplayData& UFineActorGameplay::GetDisplayData() const
+{
+	static const FFineDisplayData EmptyDisplayData;
+	return IsValid(Archetype) ? Archetype->GetDisplayData() : EmptyDisplayData;
+}
+
 void UFineActorGameplay::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	LocalDatabaseComponent = nullptr;
+	Archetype = nullptr;
 
 	Super::EndPlay(EndPlayReason);
 }
@@ -3,9 +3,14 @@
 
 #include "Actor/FineBaseAbility.h"
 
-#include "AbilitySystemBlueprintLibrary.h"
 #include "AbilitySystemComponent.h"
+#include "FinePlayGameplayTags.h"
 #include "FinePlayLog.h"
+#include "Actor/FineCharacterGameplay.h"
+#include "Diagnostics/FineAbilityBenchmark.h"
+#include "Diagnostics/FineInputLatency.h"
+#include "Diagnostics/FinePlayEventRing.h"
+#include "Diagnostics/FinePlayStats.h"
 
 
 bool UFineBaseAbility::CanActivateAbility(const FGameplayAbilitySpecHandle Handle,
@@ -14,15 +19,24 @@ bool UFineBaseAbility::CanActivateAbility(const FGameplayAbilitySpecHandle Handl
                                           const FGameplayTagContainer* TargetTags,
                                           FGameplayTagContainer* OptionalRelevantTags) const
 {
+	FineAbilityBenchmark::FScopedPhase BenchmarkPhase(EFineAbilityPhase::CanActivate);
 	if (!Super::CanActivateAbility(Handle, ActorInfo, SourceTags, TargetTags, OptionalRelevantTags))
 	{
 		return false;
 	}
-	static const auto AliveTag = FGameplayTag::RequestGameplayTag(FName("Actor.State.Alive"));
-	const auto AbilitySystem = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(ActorInfo->AvatarActor.Get());
-	const auto CanActivate = AbilitySystem->HasMatchingGameplayTag(AliveTag);
-	FP_LOG("CanActivate %s ? %s", *GetClass()->GetDisplayNameText().ToString(),
-	       CanActivate ? TEXT("true") : TEXT("false"));
+	bool CanActivate;
+	if (const auto CharacterGameplay = UFineCharacterGameplay::FindCharacterGameplay(ActorInfo->AvatarActor.Get()))
+	{
+		CanActivate = CharacterGameplay->HasState(EFineCharacterState::Alive);
+	}
+	else
+	{
+		const auto AbilitySystem = ActorInfo->AbilitySystemComponent.Get();
+		CanActivate = IsValid(AbilitySystem) &&
+			AbilitySystem->HasMatchingGameplayTag(FinePlayGameplayTags::Actor_State_Alive);
+	}
+	FP_RECORD_EVENT("CanActivate", GetClass()->GetFName(), CanActivate);
+	FP_ABILITY_VERBOSE("CanActivate %s ? %s", *GetClass()->GetName(), CanActivate ? TEXT("true") : TEXT("false"));
 	return CanActivate;
 }
 
@@ -31,6 +45,8 @@ void UFineBaseAbility::ActivateAbility(const FGameplayAbilitySpecHandle Handle,
                                        const FGameplayAbilityActivationInfo ActivationInfo,
                                        const FGameplayEventData* TriggerEventData)
 {
+	FP_SCOPE_CALL(AbilityActivation);
+	FineInputLatency::Mark(ActorInfo ? ActorInfo->AvatarActor.Get() : nullptr, EFineInputLatencyStage::Activated);
 	if (!HasAuthorityOrPredictionKey(ActorInfo, &ActivationInfo))
 	{
 		return;
@@ -40,14 +56,28 @@ void UFineBaseAbility::ActivateAbility(const FGameplayAbilitySpecHandle Handle,
 		EndAbility(Handle, ActorInfo, ActivationInfo, true, true);
 		return;
 	}
-	CommitAbility(Handle, ActorInfo, ActivationInfo);
-	const auto EffectClasses = GetEffectClasses();
+	{
+		FineAbilityBenchmark::FScopedPhase BenchmarkPhase(EFineAbilityPhase::Commit);
+		CommitAbility(Handle, ActorInfo, ActivationInfo);
+	}
+	const auto& EffectClasses = GetCachedEffectClasses();
 	if (EffectClasses.IsEmpty())
 	{
 		FP_ERROR("EffectClass is null.");
 		EndAbility(Handle, ActorInfo, ActivationInfo, true, true);
 		return;
 	}
+	FineAbilityBenchmark::FScopedPhase BenchmarkPhase(EFineAbilityPhase::ApplyEffects);
+	// Drain lazily instead of with periodic effects if the character regenerates that way.
+	const auto CharacterGameplay = UFineCharacterGameplay::FindCharacterGameplay(ActorInfo->AvatarActor.Get());
+	const auto bLazyDrain = IsValid(CharacterGameplay) && CharacterGameplay->IsResourceDrainLazy() &&
+		(StaminaDrainRate != 0.f || ManaDrainRate != 0.f);
+	if (bLazyDrain)
+	{
+		CharacterGameplay->AddResourceDrainRates(StaminaDrainRate, ManaDrainRate);
+		DrainedCharacterGameplay = CharacterGameplay;
+	}
+	const auto Level = GetAbilityLevel(Handle, ActorInfo);
 	for (const auto& EffectClass : EffectClasses)
 	{
 		if (!EffectClass)
@@ -56,12 +86,15 @@ void UFineBaseAbility::ActivateAbility(const FGameplayAbilitySpecHandle Handle,
 			EndAbility(Handle, ActorInfo, ActivationInfo, true, true);
 			return;
 		}
+		if (bLazyDrain && DrainEffectClasses.Contains(EffectClass))
+		{
+			continue;
+		}
 
-		const auto NewSpec = MakeOutgoingGameplayEffectSpec(EffectClass, GetAbilityLevel(Handle, ActorInfo));
 		EffectHandles.Add(ApplyGameplayEffectSpecToOwner(Handle, ActorInfo, ActivationInfo,
-		                                                 MakeOutgoingGameplayEffectSpec(
-			                                                 EffectClass, GetAbilityLevel(Handle, ActorInfo))));
-		FP_LOG("Apply %s effect to owner", *EffectClass->GetDisplayNameText().ToString());
+		                                                 GetOutgoingEffectSpec(
+			                                                 Handle, ActorInfo, ActivationInfo, EffectClass, Level)));
+		FP_ABILITY_VERBOSE("Apply %s effect to owner", *EffectClass->GetName());
 	}
 }
 
@@ -90,7 +123,8 @@ void UFineBaseAbility::CancelAbility(const FGameplayAbilitySpecHandle Handle,
 	}
 
 	Super::CancelAbility(Handle, ActorInfo, ActivationInfo, bReplicateCancelAbility);
-	FP_LOG("%s effect removed.", *GetClass()->GetDisplayNameText().ToString());
+	FP_RECORD_EVENT("CancelAbility", GetClass()->GetFName());
+	FP_ABILITY_VERBOSE("%s effect removed.", *GetClass()->GetName());
 }
 
 void UFineBaseAbility::EndAbility(const FGameplayAbilitySpecHandle Handle,
@@ -98,15 +132,71 @@ void UFineBaseAbility::EndAbility(const FGameplayAbilitySpecHandle Handle,
                                   const FGameplayAbilityActivationInfo ActivationInfo,
                                   bool bReplicateEndAbility, bool bWasCancelled)
 {
+	FineAbilityBenchmark::FScopedPhase BenchmarkPhase(EFineAbilityPhase::End);
 	Super::EndAbility(Handle, ActorInfo, ActivationInfo, bReplicateEndAbility, bWasCancelled);
 	for (const auto EffectHandle : EffectHandles)
 	{
 		BP_RemoveGameplayEffectFromOwnerWithHandle(EffectHandle);
 	}
-	EffectHandles.Empty();
+	// Keep the allocation for the next activation.
+	EffectHandles.Reset();
+	if (const auto CharacterGameplay = DrainedCharacterGameplay.Get())
+	{
+		CharacterGameplay->AddResourceDrainRates(-StaminaDrainRate, -ManaDrainRate);
+	}
+	DrainedCharacterGameplay = nullptr;
+}
+
+void UFineBaseAbility::OnAvatarSet(const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilitySpec& Spec)
+{
+	Super::OnAvatarSet(ActorInfo, Spec);
+	// Cached specs reference the previous avatar in their context.
+	ClearEffectSpecCache();
 }
 
 TArray<TSubclassOf<UGameplayEffect>> UFineBaseAbility::GetEffectClasses()
 {
 	return {};
 }
+
+const TArray<TSubclassOf<UGameplayEffect>>& UFineBaseAbility::GetCachedEffectClasses()
+{
+	if (!bEffectClassesCached)
+	{
+		CachedEffectClasses = GetEffectClasses();
+		bEffectClassesCached = true;
+	}
+	return CachedEffectClasses;
+}
+
+FGameplayEffectSpecHandle UFineBaseAbility::GetOutgoingEffectSpec(const FGameplayAbilitySpecHandle Handle,
+                                                                  const FGameplayAbilityActorInfo* ActorInfo,
+                                                                  const FGameplayAbilityActivationInfo ActivationInfo,
+                                                                  TSubclassOf<UGameplayEffect> EffectClass,
+                                                                  float Level)
+{
+	// Non instanced abilities run on the class default object, shared by all actors.
+	if (GetInstancingPolicy() == EGameplayAbilityInstancingPolicy::NonInstanced)
+	{
+		return MakeOutgoingGameplayEffectSpec(Handle, ActorInfo, ActivationInfo, EffectClass, Level);
+	}
+	for (const auto& CachedSpec : CachedEffectSpecs)
+	{
+		if (CachedSpec.EffectClass == EffectClass && CachedSpec.Level == Level && CachedSpec.SpecHandle.IsValid())
+		{
+			// Source tags and attributes may have changed since the last activation.
+			CachedSpec.SpecHandle.Data->CaptureDataFromSource();
+			return CachedSpec.SpecHandle;
+		}
+	}
+	auto& CachedSpec = CachedEffectSpecs.AddDefaulted_GetRef();
+	CachedSpec.EffectClass = EffectClass;
+	CachedSpec.Level = Level;
+	CachedSpec.SpecHandle = MakeOutgoingGameplayEffectSpec(Handle, ActorInfo, ActivationInfo, EffectClass, Level);
+	return CachedSpec.SpecHandle;
+}
+
+void UFineBaseAbility::ClearEffectSpecCache()
+{
+	CachedEffectSpecs.Reset();
+}
@@ -3,12 +3,21 @@
 
 #include "Actor/FineCharacterAttributeSet.h"
 
+#include "FinePlayGameplayTags.h"
 #include "FinePlayLog.h"
+#include "Diagnostics/FineGameplayTagProfiler.h"
+#include "Diagnostics/FinePlayEventRing.h"
 #include "GameplayEffectExtension.h"
 #include "GameplayEffectTypes.h"
 #include "Actor/FineCharacterGameplay.h"
-#include "Control/FineMovementInputControl.h"
-#include "GameFramework/Character.h"
+#include "Actor/FineResourceRegenSubsystem.h"
+#include "Engine/World.h"
+
+UFineCharacterAttributeSet::UFineCharacterAttributeSet(): Super()
+{
+	InvincibleTag = FinePlayGameplayTags::Actor_State_Invincible;
+	ExhaustedTag = FinePlayGameplayTags::Actor_State_Exhausted;
+}
 
 bool UFineCharacterAttributeSet::PreGameplayEffectExecute(FGameplayEffectModCallbackData& Data)
 {
@@ -18,14 +27,29 @@ bool UFineCharacterAttributeSet::PreGameplayEffectExecute(FGameplayEffectModCall
 	// Is Damage about to be applied?
 	if (DamageProperty == ModifiedProperty)
 	{
-		// Check if the owner has the invincible tag
-		const auto Tag = FGameplayTag::RequestGameplayTag(FName(TEXT("Actor.State.Invincible")));
-		if (Data.Target.HasMatchingGameplayTag(Tag))
+		// Check if the owner is invincible, by state flags if it's a FinePlay character.
+		const auto Gameplay = CharacterGameplay.Get();
+		if (Gameplay ? Gameplay->HasState(EFineCharacterState::Invincible)
+			    : Data.Target.HasMatchingGameplayTag(InvincibleTag))
 		{
 			// Don't take damage while invincible
 			return false;
 		}
 	}
+	// Let the effect modify the current value of a continuous resource, not the one last written.
+	const auto ContinuousIndex = GetContinuousIndex(Data.EvaluatedData.Attribute);
+	if (ContinuousIndex != INDEX_NONE)
+	{
+		if (bContinuous[ContinuousIndex])
+		{
+			SettleContinuous(ContinuousIndex);
+		}
+		// Same for batched regeneration, which syncs back from the attribute after the effect.
+		else if (const auto RegenSubsystem = UFineResourceRegenSubsystem::Get(GetOwningActor()))
+		{
+			RegenSubsystem->WriteBack(this);
+		}
+	}
 	return true;
 }
 
@@ -34,41 +58,24 @@ void UFineCharacterAttributeSet::PostGameplayEffectExecute(const FGameplayEffect
 	Super::PostGameplayEffectExecute(Data);
 
 	static auto DamageProperty = GetIncomingDamageAttribute().GetUProperty();
-	static auto StaminaProperty = GetStaminaAttribute().GetUProperty();
 	const FProperty* ModifiedProperty = Data.EvaluatedData.Attribute.GetUProperty();
 
 	// What property was modified?
 	if (DamageProperty == ModifiedProperty)
 	{
-		// Treat damage as minus health
-		SetHealth(GetHealth() - GetIncomingDamage());
-		SetIncomingDamage(0);
-	}
-	else if (StaminaProperty == ModifiedProperty)
-	{
-		// Cancel sprint if stamina is depleted
-		if (GetStamina() <= 0)
+		if (const auto Aggregator = DamageAggregator.Get())
 		{
-			// Get the character's ability system component, and cancel the sprint ability
-			const auto AbilitySystem = GetOwningAbilitySystemComponent();
-			if (ensure(IsValid(AbilitySystem)))
-			{
-				// Get movement input control from player controller.
-				const auto AvatarActor = Cast<ACharacter>(AbilitySystem->GetAvatarActor());
-				const auto PlayerController = Cast<APlayerController>(AvatarActor->GetController());
-				if (!ensure(IsValid(PlayerController)))
-				{
-					return;
-				}
-				const auto MovementInputControl = PlayerController->FindComponentByClass<UFineMovementInputControl>();
-				const auto SprintAbility = AbilitySystem->FindAbilitySpecFromInputID(
-					MovementInputControl->GetRunActionInputID());
-				if (IsValid(SprintAbility->Ability))
-				{
-					AbilitySystem->CancelAbility(SprintAbility->Ability);
-				}
-			}
+			// Applied together with the other hits of this frame.
+			const auto& Context = Data.EffectSpec.GetContext();
+			const auto Source = IsValid(Context.GetEffectCauser()) ? Context.GetEffectCauser() : Context.GetInstigator();
+			Aggregator->AccumulateDamage(GetIncomingDamage(), Source);
 		}
+		else
+		{
+			// Treat damage as minus health
+			SetHealth(GetHealth() - GetIncomingDamage());
+		}
+		SetIncomingDamage(0);
 	}
 }
 
@@ -97,23 +104,190 @@ void UFineCharacterAttributeSet::PostAttributeChange(const FGameplayAttribute& A
 {
 	if (Attribute.GetUProperty() == GetStaminaAttribute().GetUProperty())
 	{
-		static const auto ExhaustedTag = FGameplayTag::RequestGameplayTag(FName(TEXT("Actor.State.Exhausted")));
-		const auto AbilitySystem = GetOwningAbilitySystemComponent();
-		if (FMath::IsNearlyEqual(NewValue, GetMaxStamina(), UE_KINDA_SMALL_NUMBER))
+		UpdateExhaustedTag(NewValue);
+	}
+
+	// Continuous resources restart from whatever was written.
+	for (int32 Index = 0; Index < ContinuousResourceCount; ++Index)
+	{
+		if (!bContinuous[Index])
 		{
-			if (AbilitySystem->HasMatchingGameplayTag(ExhaustedTag))
-			{
-				AbilitySystem->RemoveLooseGameplayTag(ExhaustedTag);
-				FP_LOG("ExhaustedTag removed");
-			}
+			continue;
 		}
-		else
+		if (Attribute == GetContinuousAttribute(Index))
+		{
+			RebaseContinuous(Index, NewValue);
+		}
+		else if (Attribute == (Index == ContinuousStamina ? GetMaxStaminaAttribute() : GetMaxManaAttribute()))
+		{
+			// Resume from the value reached under the old maximum, then clamp to the new one.
+			RebaseContinuous(Index, ContinuousResources[Index].Evaluate(GetWorldTime(), OldValue));
+			SettleContinuous(Index);
+		}
+	}
+}
+
+void UFineCharacterAttributeSet::SetContinuousRate(const FGameplayAttribute& Attribute, float Rate)
+{
+	const auto Index = GetContinuousIndex(Attribute);
+	if (!ensureMsgf(Index != INDEX_NONE, TEXT("Only stamina and mana can change continuously.")))
+	{
+		return;
+	}
+	// Keep what changed with the previous rate.
+	const auto Current = GetCurrentValue(Index);
+	ContinuousResources[Index].Rate = Rate;
+	bContinuous[Index] = true;
+	RebaseContinuous(Index, Current);
+	if (Index == ContinuousStamina)
+	{
+		UpdateExhaustedTag(Current);
+	}
+}
+
+void UFineCharacterAttributeSet::StopContinuous(const FGameplayAttribute& Attribute)
+{
+	const auto Index = GetContinuousIndex(Attribute);
+	if (Index == INDEX_NONE || !bContinuous[Index])
+	{
+		return;
+	}
+	SettleContinuous(Index);
+	bContinuous[Index] = false;
+	if (const auto World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(ContinuousTimers[Index]);
+	}
+}
+
+bool UFineCharacterAttributeSet::IsContinuous(const FGameplayAttribute& Attribute) const
+{
+	const auto Index = GetContinuousIndex(Attribute);
+	return Index != INDEX_NONE && bContinuous[Index];
+}
+
+int32 UFineCharacterAttributeSet::GetContinuousIndex(const FGameplayAttribute& Attribute)
+{
+	if (Attribute == GetStaminaAttribute())
+	{
+		return ContinuousStamina;
+	}
+	if (Attribute == GetManaAttribute())
+	{
+		return ContinuousMana;
+	}
+	return INDEX_NONE;
+}
+
+FGameplayAttribute UFineCharacterAttributeSet::GetContinuousAttribute(int32 Index)
+{
+	return Index == ContinuousStamina ? GetStaminaAttribute() : GetManaAttribute();
+}
+
+float UFineCharacterAttributeSet::GetContinuousMaxValue(int32 Index) const
+{
+	return Index == ContinuousStamina ? GetMaxStamina() : GetMaxMana();
+}
+
+float UFineCharacterAttributeSet::GetCurrentValue(int32 Index) const
+{
+	if (bContinuous[Index])
+	{
+		return ContinuousResources[Index].Evaluate(GetWorldTime(), GetContinuousMaxValue(Index));
+	}
+	return GetContinuousAttribute(Index).GetNumericValue(this);
+}
+
+double UFineCharacterAttributeSet::GetWorldTime() const
+{
+	const auto World = GetWorld();
+	return IsValid(World) ? World->GetTimeSeconds() : 0.0;
+}
+
+void UFineCharacterAttributeSet::SettleContinuous(int32 Index)
+{
+	const auto Current = GetCurrentValue(Index);
+	const auto Attribute = GetContinuousAttribute(Index);
+	const auto AbilitySystem = GetOwningAbilitySystemComponent();
+	if (IsValid(AbilitySystem) && Current != Attribute.GetNumericValue(this))
+	{
+		// PostAttributeChange rebases the resource.
+		AbilitySystem->SetNumericAttributeBase(Attribute, Current);
+	}
+	else
+	{
+		RebaseContinuous(Index, Current);
+	}
+}
+
+void UFineCharacterAttributeSet::RebaseContinuous(int32 Index, float Value)
+{
+	auto& Resource = ContinuousResources[Index];
+	Resource.Value = Value;
+	Resource.Timestamp = GetWorldTime();
+	ScheduleContinuous(Index);
+}
+
+void UFineCharacterAttributeSet::ScheduleContinuous(int32 Index)
+{
+	const auto World = GetWorld();
+	if (!IsValid(World))
+	{
+		return;
+	}
+	auto& TimerManager = World->GetTimerManager();
+	TimerManager.ClearTimer(ContinuousTimers[Index]);
+	if (!bContinuous[Index])
+	{
+		return;
+	}
+	const auto TimeToBound = ContinuousResources[Index].GetTimeToBound(GetContinuousMaxValue(Index));
+	if (TimeToBound > 0.0)
+	{
+		TimerManager.SetTimer(ContinuousTimers[Index],
+		                      FTimerDelegate::CreateUObject(
+			                      this, &UFineCharacterAttributeSet::OnContinuousBoundReached, Index),
+		                      static_cast<float>(TimeToBound), false);
+	}
+}
+
+void UFineCharacterAttributeSet::OnContinuousBoundReached(int32 Index)
+{
+	// Writing the attribute toggles the exhausted tag and evaluates ability cancellation rules like any other change.
+	SettleContinuous(Index);
+	// Stamina that was full when draining started wasn't written, but the tag was added.
+	if (Index == ContinuousStamina)
+	{
+		UpdateExhaustedTag(GetCurrentValue(Index));
+	}
+}
+
+void UFineCharacterAttributeSet::UpdateExhaustedTag(float Stamina)
+{
+	const auto AbilitySystem = GetOwningAbilitySystemComponent();
+	if (!IsValid(AbilitySystem))
+	{
+		return;
+	}
+	// Continuous draining leaves the attribute full until it settles, so it counts as exhausted right away, like
+	// the first execution of a periodic drain effect.
+	const auto bDraining = bContinuous[ContinuousStamina] && ContinuousResources[ContinuousStamina].Rate < 0.f;
+	if (!bDraining && FMath::IsNearlyEqual(Stamina, GetMaxStamina(), UE_KINDA_SMALL_NUMBER))
+	{
+		if (AbilitySystem->HasMatchingGameplayTag(ExhaustedTag))
+		{
+			FineGameplayTagProfiler::RemoveLooseTag(AbilitySystem, ExhaustedTag);
+			FP_RECORD_EVENT("ExhaustedTagRemoved", GetOwningActor()->GetFName(), Stamina);
+			FP_ATTRIBUTE_VERBOSE("ExhaustedTag removed");
+		}
+	}
+	else
+	{
+		if (!AbilitySystem->HasMatchingGameplayTag(ExhaustedTag))
 		{
-			if (!AbilitySystem->HasMatchingGameplayTag(ExhaustedTag))
-			{
-				AbilitySystem->AddLooseGameplayTag(ExhaustedTag);
-				FP_LOG("ExhaustedTag added");
-			}
+			FineGameplayTagProfiler::AddLooseTag(AbilitySystem, ExhaustedTag);
+			FP_RECORD_EVENT("ExhaustedTagAdded", GetOwningActor()->GetFName(), Stamina);
+			FP_ATTRIBUTE_VERBOSE("ExhaustedTag added");
 		}
 	}
 }
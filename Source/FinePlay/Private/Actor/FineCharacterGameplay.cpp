@@ -5,100 +5,246 @@
 
 #include "AbilitySystemBlueprintLibrary.h"
 #include "AbilitySystemComponent.h"
+#include "FinePlayGameplayTags.h"
 #include "FinePlayLog.h"
+#include "Actor/FineActorArchetype.h"
 #include "Actor/FineCharacterAttributeSet.h"
+#include "Actor/FineMovementStateSubsystem.h"
+#include "Actor/FinePaperCharacter.h"
+#include "Actor/FineResourceRegenSubsystem.h"
 #include "Components/CapsuleComponent.h"
-#include "Data/FineDatabaseRecord.h"
-#include "Data/FineLocalDatabaseComponent.h"
+#include "Diagnostics/FineGameplayTagProfiler.h"
+#include "Diagnostics/FineInputLatency.h"
+#include "Diagnostics/FinePlayStats.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "GameplayEffect.h"
 
+/// Per second rate of the additive modifiers of a periodic effect on the attribute, at level 1.
+static float GetPeriodicEffectRate(const UGameplayEffect& Effect, const FGameplayAttribute& Attribute)
+{
+	const auto Period = Effect.Period.GetValueAtLevel(1.f);
+	if (Period <= 0.f)
+	{
+		return 0.f;
+	}
+	float Amount = 0.f;
+	for (const auto& Modifier : Effect.Modifiers)
+	{
+		float Magnitude;
+		if (Modifier.Attribute == Attribute && Modifier.ModifierOp == EGameplayModOp::Additive &&
+			Modifier.ModifierMagnitude.GetStaticMagnitudeIfPossible(1.f, Magnitude))
+		{
+			Amount += Magnitude;
+		}
+	}
+	return Amount / Period;
+}
 
 // Sets default values for this component's properties
 UFineCharacterGameplay::UFineCharacterGameplay(): Super()
 {
+	// Ticks only while there is a snapshot to publish.
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+	StaminaRefillEffectClass = TSoftClassPtr<UGameplayEffect>(
+		FSoftObjectPath(TEXT("/FinePlay/Ability/GE_Refill_Stamina.GE_Refill_Stamina_C")));
 	AttributeSetClass = UFineCharacterAttributeSet::StaticClass();
-	AliveGameplayTagName = TEXT("Actor.State.Alive");
-	InvincibleGameplayTagName = TEXT("Actor.State.Invincible");
-	JumpGameplayTagName = TEXT("Actor.State.Jumping");
-	RunGameplayTagName = TEXT("Actor.State.Running");
+	AliveTag = FinePlayGameplayTags::Actor_State_Alive;
+	InvincibleTag = FinePlayGameplayTags::Actor_State_Invincible;
+	JumpTag = FinePlayGameplayTags::Actor_State_Jumping;
+	RunTag = FinePlayGameplayTags::Actor_State_Running;
+	MovingTag = FinePlayGameplayTags::Actor_State_Moving;
+	ExhaustedTag = FinePlayGameplayTags::Actor_State_Exhausted;
+	AliveGameplayTagName = AliveTag.GetTagName();
+	InvincibleGameplayTagName = InvincibleTag.GetTagName();
+	JumpGameplayTagName = JumpTag.GetTagName();
+	RunGameplayTagName = RunTag.GetTagName();
+	MovingGameplayTagName = MovingTag.GetTagName();
+	ExhaustedGameplayTagName = ExhaustedTag.GetTagName();
 }
 
 bool UFineCharacterGameplay::IsAlive()
 {
-	// Requires Actor.State.Invincible gameplay tag
-	static const auto Tag = FGameplayTag::RequestGameplayTag(AliveGameplayTagName);
-	return AbilitySystemComponent->HasMatchingGameplayTag(Tag);
+	return HasState(EFineCharacterState::Alive);
 }
 
 bool UFineCharacterGameplay::IsInvincible()
 {
-	// Requires Actor.State.Invincible gameplay tag
-	static const auto Tag = FGameplayTag::RequestGameplayTag(InvincibleGameplayTagName);
-	return AbilitySystemComponent->HasMatchingGameplayTag(Tag);
+	return HasState(EFineCharacterState::Invincible);
+}
+
+UFineCharacterGameplay* UFineCharacterGameplay::FindCharacterGameplay(const AActor* Actor)
+{
+	if (const auto Character = Cast<AFinePaperCharacter>(Actor))
+	{
+		return Character->GetCharacterGameplay();
+	}
+	return IsValid(Actor) ? Actor->FindComponentByClass<UFineCharacterGameplay>() : nullptr;
 }
 
 FGameplayAbilitySpecHandle UFineCharacterGameplay::AddAbilityByClass(UClass* InClass, int32 InLevel, int32 InInputID,
                                                                      UObject* InSourceObject)
 {
-	// Add ability to ability system.
-	const auto AbilitySystem = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(GetOwner());
-	const TSubclassOf<UGameplayAbility> AbilityClass = InClass;
-	const auto Handle = AbilitySystem->GiveAbility(
-		FGameplayAbilitySpec(AbilityClass, InLevel, InInputID, IsValid(InSourceObject) ? InSourceObject : this));
-	AbilityHandles.Add(Handle);
-
-	FP_LOG("Gave ability: %s, %i, %i", *InClass->GetName(), InLevel, InInputID);
-	return Handle;
+	FFineAbilityGrant Grant;
+	Grant.AbilityClass = InClass;
+	Grant.Level = InLevel;
+	Grant.InputID = InInputID;
+	Grant.SourceObject = InSourceObject;
+	TArray<FGameplayAbilitySpecHandle> Handles;
+	GrantAbilities({Grant}, Handles);
+	return Handles.IsEmpty() ? FGameplayAbilitySpecHandle() : Handles[0];
 }
 
 void UFineCharacterGameplay::RemoveAbilityByClass(UClass* InClass)
 {
-	const auto AbilitySystem = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(GetOwner());
-	const TSubclassOf<UGameplayAbility> AbilityClass = InClass;
-	for (const auto AbilityHandle : AbilityHandles)
+	TArray<FGameplayAbilitySpecHandle> Handles;
+	AbilityRegistry.FindByClassOrSubclass(InClass, Handles);
+	if (Handles.IsEmpty())
+	{
+		return;
+	}
+	RevokeAbilities({Handles[0]});
+	FP_ABILITY_LOG("Removed ability: %s", *InClass->GetName());
+}
+
+void UFineCharacterGameplay::GrantAbilities(const TArray<FFineAbilityGrant>& Grants,
+                                            TArray<FGameplayAbilitySpecHandle>& OutHandles)
+{
+	FP_SCOPE_CALL(AbilityGrant);
+	const auto AbilitySystem = SetAndGetAbilitySystemComponent();
+	if (!ensure(IsValid(AbilitySystem)))
+	{
+		return;
+	}
+	OutHandles.Reserve(OutHandles.Num() + Grants.Num());
+	{
+		// Spec list updates are deferred until the lock is released.
+		FScopedAbilityListLock AbilityListLock(*AbilitySystem);
+		for (const auto& Grant : Grants)
+		{
+			if (!Grant.AbilityClass)
+			{
+				FP_ERROR("Invalid ability class.");
+				continue;
+			}
+			UObject* SourceObject = IsValid(Grant.SourceObject) ? Grant.SourceObject.Get() : this;
+			const auto Handle = AbilitySystem->GiveAbility(
+				FGameplayAbilitySpec(Grant.AbilityClass, Grant.Level, Grant.InputID, SourceObject));
+			AbilityRegistry.Add(Handle, Grant.AbilityClass, Grant.InputID, SourceObject);
+			OutHandles.Add(Handle);
+			FP_ABILITY_LOG("Gave ability: %s, %i, %i", *Grant.AbilityClass->GetName(), Grant.Level, Grant.InputID);
+		}
+	}
+	CompileAbilityCancellationRules();
+}
+
+void UFineCharacterGameplay::RevokeAbilities(const TArray<FGameplayAbilitySpecHandle>& Handles)
+{
+	FP_SCOPE_CYCLE(AbilityGrant);
+	const auto AbilitySystem = SetAndGetAbilitySystemComponent();
+	if (!IsValid(AbilitySystem))
+	{
+		return;
+	}
 	{
-		const auto AbilitySpec = AbilitySystem->FindAbilitySpecFromHandle(AbilityHandle);
-		if (AbilitySpec->Ability->IsA(AbilityClass))
+		// Spec list updates are deferred until the lock is released.
+		FScopedAbilityListLock AbilityListLock(*AbilitySystem);
+		for (const auto& Handle : Handles)
 		{
-			AbilitySystem->ClearAbility(AbilityHandle);
-			AbilityHandles.Remove(AbilityHandle);
-			FP_LOG("Removed ability: %s", *InClass->GetName());
-			return;
+			if (AbilityRegistry.Remove(Handle))
+			{
+				AbilitySystem->ClearAbility(Handle);
+			}
 		}
 	}
+	CompileAbilityCancellationRules();
+}
+
+void UFineCharacterGameplay::RevokeAbilitiesBySourceObject(UObject* InSourceObject)
+{
+	if (const auto Handles = AbilityRegistry.FindBySourceObject(InSourceObject))
+	{
+		// Copy since revoking updates the index.
+		RevokeAbilities(TArray<FGameplayAbilitySpecHandle>(*Handles));
+	}
+}
+
+int32 UFineCharacterGameplay::AddAbilityCancellationRule(const FFineAbilityCancellationRule& Rule)
+{
+	const auto RuleID = CancellationRules.Add(Rule);
+	CompileAbilityCancellationRules();
+	return RuleID;
+}
+
+void UFineCharacterGameplay::RemoveAbilityCancellationRule(int32 RuleID)
+{
+	if (CancellationRules.Remove(RuleID))
+	{
+		CompileAbilityCancellationRules();
+	}
+}
+
+FGameplayAbilitySpecHandle UFineCharacterGameplay::FindAbilityHandleByClass(UClass* InClass) const
+{
+	const auto Handles = AbilityRegistry.FindByClass(InClass);
+	return Handles ? (*Handles)[0] : FGameplayAbilitySpecHandle();
+}
+
+FGameplayAbilitySpecHandle UFineCharacterGameplay::FindAbilityHandleByInputID(int32 InInputID) const
+{
+	const auto Handles = AbilityRegistry.FindByInputID(InInputID);
+	return Handles ? (*Handles)[0] : FGameplayAbilitySpecHandle();
 }
 
 float UFineCharacterGameplay::GetDistanceFromGroundStaticMesh(const FVector Offset)
 {
+	FFineGroundSample Sample;
+	if (GetGroundSample(Offset, Sample))
+	{
+		FP_VERYVERBOSE("Distance from ground static mesh: %f (Probe)", Sample.Distance);
+		return Sample.Distance;
+	}
 	// Get distance from ground static mesh.
-	static const float MaxDistance = 1000.0f;
+	const auto MaxDistance = GroundProbe.GetMaxDistance();
 	const auto Owner = GetOwner();
-	const auto Capsule = Owner->FindComponentByClass<UCapsuleComponent>();
+	const auto Capsule = GetOwnerCapsule();
 	const auto CapsuleHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
 	const auto Start = Owner->GetActorLocation() + Offset;
 	const auto ActorDownVector = Owner->GetActorUpVector() * -1.0f;
 	const auto End = Start + ActorDownVector * MaxDistance;
 	FHitResult HitResult;
-	FCollisionQueryParams CollisionQueryParams;
-	CollisionQueryParams.AddIgnoredActor(Owner);
+	const FCollisionQueryParams CollisionQueryParams(SCENE_QUERY_STAT(FineGroundTrace), false, Owner);
 	const auto bHit = GetWorld()->LineTraceSingleByChannel(
 		HitResult, Start, End, ECC_Visibility, CollisionQueryParams);
 	if (bHit)
 	{
 		const auto FinalDistance = HitResult.Distance - CapsuleHalfHeight;
-		FP_VERBOSE("Distance from ground static mesh: %f", FinalDistance);
+		FP_VERYVERBOSE("Distance from ground static mesh: %f", FinalDistance);
 		return FinalDistance;
 	}
-	FP_VERBOSE("Distance from ground static mesh: %f (Max)", MaxDistance);
+	FP_VERYVERBOSE("Distance from ground static mesh: %f (Max)", MaxDistance);
 	return MaxDistance;
 }
 
+bool UFineCharacterGameplay::GetGroundSample(const FVector Offset, FFineGroundSample& OutSample)
+{
+	const auto Owner = GetOwner();
+	const auto Capsule = GetOwnerCapsule();
+	if (!IsValid(Capsule))
+	{
+		return false;
+	}
+	GroundProbe.Update(Owner, Capsule->GetScaledCapsuleHalfHeight());
+	return GroundProbe.GetSample(Offset, OutSample);
+}
+
 FVector UFineCharacterGameplay::GetFeetLocation() const
 {
 	// get owner
 	const auto Owner = GetOwner();
 	// get capsule
-	const auto Capsule = Owner->FindComponentByClass<UCapsuleComponent>();
+	const auto Capsule = GetOwnerCapsule();
 	// get capsule half height
 	const auto CapsuleHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
 	// get actor location
@@ -115,7 +261,7 @@ FVector UFineCharacterGameplay::GetHeadLocation() const
 	// get owner
 	const auto Owner = GetOwner();
 	// get capsule
-	const auto Capsule = Owner->FindComponentByClass<UCapsuleComponent>();
+	const auto Capsule = GetOwnerCapsule();
 	// get capsule half height
 	const auto CapsuleHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
 	// get actor location
@@ -131,7 +277,7 @@ void UFineCharacterGameplay::AddLooseGameplayTagForAbilitySystem(const FGameplay
 {
 	if (AbilitySystemComponent.IsValid())
 	{
-		AbilitySystemComponent->AddLooseGameplayTag(Tag);
+		FineGameplayTagProfiler::AddLooseTag(AbilitySystemComponent.Get(), Tag);
 	}
 }
 
@@ -139,49 +285,75 @@ void UFineCharacterGameplay::RemoveLooseGameplayTagForAbilitySystem(const FGamep
 {
 	if (AbilitySystemComponent.IsValid())
 	{
-		AbilitySystemComponent->RemoveLooseGameplayTag(Tag);
+		FineGameplayTagProfiler::RemoveLooseTag(AbilitySystemComponent.Get(), Tag);
 	}
 }
 
+void UFineCharacterGameplay::OnRegister()
+{
+	Super::OnRegister();
+	CacheOwnerComponents();
+	// Before BeginPlay, since controllers possessing the character earlier bind to these tags.
+	ResolveGameplayTags();
+}
+
 void UFineCharacterGameplay::BeginPlay()
 {
 	Super::BeginPlay();
 
+	GroundProbe.Configure(GroundProbeSampleCount, GroundProbeRadius, 1000.f, bAsyncGroundTraces);
+
 	// Get ability system by finding the component from the owner.
 	const auto Owner = GetOwner();
 	auto AbilitySystem = SetAndGetAbilitySystemComponent();
 	
 	check(IsValid(AbilitySystem));
+	BindStateTagEvents(AbilitySystem);
 	const auto AttributeSet = NewObject<UFineCharacterAttributeSet>(Owner, AttributeSetClass);
+	CachedAttributeSet = AttributeSet;
+	AttributeSet->SetStateTags(InvincibleTag, ExhaustedTag);
+	AttributeSet->SetCharacterGameplay(this);
+	if (bAggregateDamage)
+	{
+		AttributeSet->SetDamageAggregator(this);
+	}
 	AbilitySystem->AddSpawnedAttribute(AttributeSet);
 
-	// Use local database component to get the record for the ability attribute set.
-	const auto Database = GetLocalDatabaseComponent();
-	if (ensure(IsValid(Database)))
+	// Initialize attributes from the archetype shared by all characters with the same actor name.
+	const auto Archetype = GetArchetype();
+	if (IsValid(Archetype) && Archetype->HasAttributeData())
 	{
-		// database record from local database component
-		bool bSuccess = false;
-		const auto Record = Database->GetRecordByName(
-			TEXT("CharacterAttributeSet"), ActorName, bSuccess);
-		if (bSuccess)
-		{
-			AttributeSet->InitHealth(Record.FloatFields[TEXT("Health")]);
-			AttributeSet->MaxHealth = Record.FloatFields[TEXT("Health")];
-			AttributeSet->InitMana(Record.FloatFields[TEXT("Mana")]);
-			AttributeSet->MaxMana = Record.FloatFields[TEXT("Mana")];
-			AttributeSet->InitMovementSpeed(Record.FloatFields[TEXT("MovementSpeed")]);
-			AttributeSet->MaxMovementSpeed = 1000.f;
-			AttributeSet->InitAttackPower(Record.FloatFields[TEXT("AttackPower")]);
-			AttributeSet->InitDefensePower(Record.FloatFields[TEXT("DefensePower")]);
-			AttributeSet->InitStamina(Record.FloatFields[TEXT("Stamina")]);
-			AttributeSet->MaxStamina = Record.FloatFields[TEXT("Stamina")];
-		}
+		const auto& AttributeData = Archetype->GetAttributeData();
+		AttributeSet->InitHealth(AttributeData.Health);
+		AttributeSet->MaxHealth = AttributeData.Health;
+		AttributeSet->InitMana(AttributeData.Mana);
+		AttributeSet->MaxMana = AttributeData.Mana;
+		AttributeSet->InitMovementSpeed(AttributeData.MovementSpeed);
+		AttributeSet->MaxMovementSpeed = 1000.f;
+		AttributeSet->InitAttackPower(AttributeData.AttackPower);
+		AttributeSet->InitDefensePower(AttributeData.DefensePower);
+		AttributeSet->InitStamina(AttributeData.Stamina);
+		AttributeSet->MaxStamina = AttributeData.Stamina;
 	}
 
 	GiveDefaultAbilities();
+	for (const auto& Rule : AbilityCancellationRules)
+	{
+		CancellationRules.Add(Rule);
+	}
+	CompileAbilityCancellationRules();
 
-	AbilitySystem->AddLooseGameplayTag(
-		FGameplayTag::RequestGameplayTag(FName(TEXT("Actor.State.Alive"))));
+	FineGameplayTagProfiler::AddLooseTag(AbilitySystem, AliveTag);
+
+	// Track the moving tag from movement updates, for players and AI alike.
+	const auto Character = Cast<ACharacter>(Owner);
+	MovementStateSubsystem = UFineMovementStateSubsystem::Get(this);
+	if (IsValid(Character) && MovementStateSubsystem.IsValid())
+	{
+		MovementStateSlot = MovementStateSubsystem->Register(Character->GetCharacterMovement(), AbilitySystem,
+		                                                     MovingTag, HasState(EFineCharacterState::Moving));
+		Character->OnCharacterMovementUpdated.AddDynamic(this, &UFineCharacterGameplay::OnCharacterMovementUpdated);
+	}
 
 	// Add listener for health change.
 	OnHealthUpdated = AbilitySystem->GetGameplayAttributeValueChangeDelegate(
@@ -193,32 +365,163 @@ void UFineCharacterGameplay::BeginPlay()
 		UFineCharacterAttributeSet::GetMovementSpeedAttribute()).AddUObject(
 		this, &UFineCharacterGameplay::OnMovementSpeedChanged);
 
-	// Apply stamina refill effect to periodically refill stamina.
-	const auto StaminaRefillClass = LoadClass<UGameplayEffect>(
-		this,TEXT("/FinePlay/Ability/GE_Refill_Stamina.GE_Refill_Stamina_C"));
-	AbilitySystem->ApplyGameplayEffectToSelf(StaminaRefillClass->GetDefaultObject<UGameplayEffect>(), 1.0f,
-	                                                  AbilitySystem->MakeEffectContext());
+	// Publish the snapshot whenever an attribute changes.
+	for (const auto& Attribute : {
+		     UFineCharacterAttributeSet::GetHealthAttribute(), UFineCharacterAttributeSet::GetMaxHealthAttribute(),
+		     UFineCharacterAttributeSet::GetManaAttribute(), UFineCharacterAttributeSet::GetMaxManaAttribute(),
+		     UFineCharacterAttributeSet::GetMovementSpeedAttribute(),
+		     UFineCharacterAttributeSet::GetMaxMovementSpeedAttribute(),
+		     UFineCharacterAttributeSet::GetAttackPowerAttribute(),
+		     UFineCharacterAttributeSet::GetDefensePowerAttribute(),
+		     UFineCharacterAttributeSet::GetStaminaAttribute(), UFineCharacterAttributeSet::GetMaxStaminaAttribute()
+	     })
+	{
+		SnapshotAttributeHandles.Emplace(Attribute, AbilitySystem->GetGameplayAttributeValueChangeDelegate(Attribute).
+		                                 AddUObject(this, &UFineCharacterGameplay::OnSnapshotAttributeChanged));
+	}
+	PublishSnapshot();
+
+	// Regenerate as fast as the refill effect unless a rate is set.
+	if (ResourceRegenMode != EFineResourceRegenMode::PeriodicEffect && StaminaRegenRate < 0.f)
+	{
+		const auto StaminaRefillClass = StaminaRefillEffectClass.LoadSynchronous();
+		StaminaRegenRate = IsValid(StaminaRefillClass)
+			                   ? GetPeriodicEffectRate(*StaminaRefillClass->GetDefaultObject<UGameplayEffect>(),
+			                                           UFineCharacterAttributeSet::GetStaminaAttribute())
+			                   : 0.f;
+	}
+
+	switch (ResourceRegenMode)
+	{
+	case EFineResourceRegenMode::Batched:
+		{
+			// Regenerate together with all other characters.
+			const auto RegenSubsystem = UFineResourceRegenSubsystem::Get(this);
+			if (ensure(IsValid(RegenSubsystem)))
+			{
+				RegenSubsystem->Register(AttributeSet, StaminaRegenRate, ManaRegenRate);
+			}
+			break;
+		}
+	case EFineResourceRegenMode::Continuous:
+		{
+			// Evaluated on read, the attribute set wakes up only when a value becomes empty or full.
+			AttributeSet->SetContinuousRate(UFineCharacterAttributeSet::GetStaminaAttribute(), StaminaRegenRate);
+			AttributeSet->SetContinuousRate(UFineCharacterAttributeSet::GetManaAttribute(), ManaRegenRate);
+			break;
+		}
+	case EFineResourceRegenMode::PeriodicEffect:
+		{
+			// Apply stamina refill effect to periodically refill stamina.
+			const auto StaminaRefillClass = StaminaRefillEffectClass.LoadSynchronous();
+			if (ensure(IsValid(StaminaRefillClass)))
+			{
+				AbilitySystem->ApplyGameplayEffectToSelf(StaminaRefillClass->GetDefaultObject<UGameplayEffect>(), 1.0f,
+				                                         AbilitySystem->MakeEffectContext());
+			}
+			break;
+		}
+	}
 }
 
 void UFineCharacterGameplay::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+	FlushDamage();
+	if (IsValid(CachedAttributeSet))
+	{
+		CachedAttributeSet->SetDamageAggregator(nullptr);
+		CachedAttributeSet->SetCharacterGameplay(nullptr);
+	}
+	if (const auto RegenSubsystem = UFineResourceRegenSubsystem::Get(this))
+	{
+		RegenSubsystem->Unregister(CachedAttributeSet);
+	}
+	if (const auto Character = Cast<ACharacter>(GetOwner()))
+	{
+		Character->OnCharacterMovementUpdated.RemoveDynamic(this, &UFineCharacterGameplay::OnCharacterMovementUpdated);
+	}
+	if (MovementStateSubsystem.IsValid())
+	{
+		MovementStateSubsystem->Unregister(MovementStateSlot);
+	}
+	MovementStateSubsystem = nullptr;
+	MovementStateSlot = INDEX_NONE;
+	if (IsValid(CachedAttributeSet))
+	{
+		CachedAttributeSet->StopContinuous(UFineCharacterAttributeSet::GetStaminaAttribute());
+		CachedAttributeSet->StopContinuous(UFineCharacterAttributeSet::GetManaAttribute());
+	}
 	// remove listener for health change.
 	AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(
 		UFineCharacterAttributeSet::GetHealthAttribute()).Remove(OnHealthUpdated);
+	UnbindStateTagEvents(AbilitySystemComponent.Get());
+	for (const auto& Pair : SnapshotAttributeHandles)
+	{
+		AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(Pair.Key).Remove(Pair.Value);
+	}
+	SnapshotAttributeHandles.Empty();
+	for (const auto& Pair : CancellationAttributeHandles)
+	{
+		AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(Pair.Key).Remove(Pair.Value);
+	}
+	CancellationAttributeHandles.Empty();
+	CancellationRules.Reset();
+	CachedAttributeSet = nullptr;
 	AbilitySystemComponent = nullptr;
+	GroundProbe.Reset();
 	Super::EndPlay(EndPlayReason);
 }
 
+void UFineCharacterGameplay::TickComponent(float DeltaTime, ELevelTick TickType,
+                                           FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	FlushDamage();
+	if (bSnapshotDirty)
+	{
+		PublishSnapshot();
+	}
+	SetComponentTickEnabled(false);
+}
+
+void UFineCharacterGameplay::AccumulateDamage(float Damage, AActor* Source)
+{
+	PendingDamage.TotalDamage += Damage;
+	++PendingDamage.HitCount;
+	if (IsValid(Source))
+	{
+		PendingDamage.Sources.AddUnique(Source);
+	}
+	if (GetHealth() - PendingDamage.TotalDamage <= 0.f)
+	{
+		FlushDamage();
+		return;
+	}
+	// Flushed at the end of the frame.
+	SetComponentTickEnabled(true);
+}
+
+void UFineCharacterGameplay::FlushDamage()
+{
+	if (PendingDamage.HitCount == 0 || !IsValid(CachedAttributeSet))
+	{
+		return;
+	}
+	const auto Summary = MoveTemp(PendingDamage);
+	PendingDamage = FFineDamageSummary();
+	CachedAttributeSet->SetHealth(CachedAttributeSet->GetHealth() - Summary.TotalDamage);
+	OnCharacterDamageSummarized.Broadcast(Summary);
+}
+
 void UFineCharacterGameplay::OnHealthChanged(const FOnAttributeChangeData& OnAttributeChangeData)
 {
-	static const auto AliveTag = FGameplayTag::RequestGameplayTag(AliveGameplayTagName);
 	if (OnAttributeChangeData.OldValue > 0 && OnAttributeChangeData.NewValue <= 0)
 	{
-		AbilitySystemComponent->RemoveLooseGameplayTag(AliveTag);
+		FineGameplayTagProfiler::RemoveLooseTag(AbilitySystemComponent.Get(), AliveTag);
 	}
 	else if (OnAttributeChangeData.OldValue <= 0 && OnAttributeChangeData.NewValue > 0)
 	{
-		AbilitySystemComponent->AddLooseGameplayTag(AliveTag);
+		FineGameplayTagProfiler::AddLooseTag(AbilitySystemComponent.Get(), AliveTag);
 	}
 	const auto DamageDone = OnAttributeChangeData.OldValue - OnAttributeChangeData.NewValue;
 	if (DamageDone > 0.0f)
@@ -230,8 +533,7 @@ void UFineCharacterGameplay::OnHealthChanged(const FOnAttributeChangeData& OnAtt
 void UFineCharacterGameplay::OnMovementSpeedChanged(const FOnAttributeChangeData& OnAttributeChangeData)
 {
 	// Get character movement component from the owner.
-	const auto Owner = GetOwner();
-	const auto CharacterMovementComponent = Owner->FindComponentByClass<UCharacterMovementComponent>();
+	const auto CharacterMovementComponent = GetOwnerCharacterMovement();
 	if (ensure(IsValid(CharacterMovementComponent)))
 	{
 		CharacterMovementComponent->MaxWalkSpeed = OnAttributeChangeData.NewValue;
@@ -240,42 +542,24 @@ void UFineCharacterGameplay::OnMovementSpeedChanged(const FOnAttributeChangeData
 
 void UFineCharacterGameplay::GiveDefaultAbilities()
 {
-	// Fetch the list of records from "GameplayAbility" entity for the current actor.
-	const auto Database = GetLocalDatabaseComponent();
-	if (ensure(IsValid(Database)))
+	// Ability classes are resolved once per archetype, not per character.
+	const auto Archetype = GetArchetype();
+	if (!IsValid(Archetype))
 	{
-		bool bSuccess = false;
-		const auto Records = Database->FilterRecords(
-			TEXT("GameplayAbility"), FString::Printf(TEXT("Name = '%s'"), *ActorName.ToString()), bSuccess);
-		if (bSuccess)
-		{
-			for (const auto& Record : Records)
-			{
-				const auto AbilityName = Record.StringFields.FindChecked(TEXT("AbilityName"));
-				const auto AbilityRecord = Database->GetRecordByName(TEXT("AbilityData"), *AbilityName, bSuccess);
-				if (!bSuccess) continue;
-				const auto AbilityClassPath = AbilityRecord.StringFields[TEXT("AbilityClass")];
-				const auto AbilityLevel = AbilityRecord.IntFields[TEXT("Level")];
-				const auto InputID = AbilityRecord.IntFields[TEXT("InputID")];
-				// Turn AbilityClassPath into TSubclass<UGameplayAbility>.
-				const FSoftClassPath SoftClassPath(AbilityClassPath);
-				const auto AbilityClass = SoftClassPath.TryLoadClass<UGameplayAbility>();
-
-				if (IsValid(AbilityClass))
-				{
-					AddAbilityByClass(AbilityClass, AbilityLevel, InputID);
-				}
-				else
-				{
-					FP_ERROR("Invalid ability class path: %s", *AbilityClassPath);
-				}
-			}
-		}
-		else
-		{
-			FP_LOG("GameplayAbility fetch failed.");
-		}
+		FP_LOG("No archetype to give default abilities from.");
+		return;
 	}
+	TArray<FFineAbilityGrant> Grants;
+	Grants.Reserve(Archetype->GetAbilities().Num());
+	for (const auto& Ability : Archetype->GetAbilities())
+	{
+		auto& Grant = Grants.AddDefaulted_GetRef();
+		Grant.AbilityClass = Ability.AbilityClass;
+		Grant.Level = Ability.Level;
+		Grant.InputID = Ability.InputID;
+	}
+	TArray<FGameplayAbilitySpecHandle> Handles;
+	GrantAbilities(Grants, Handles);
 }
 
 float UFineCharacterGameplay::GetHealth() const
@@ -308,7 +592,13 @@ void UFineCharacterGameplay::SetMaxHealth(float InMaxHealth)
 
 float UFineCharacterGameplay::GetMana() const
 {
-	return GetAttributeSet()->GetMana();
+	// Batched regeneration writes back to the attribute set only now and then.
+	float Mana;
+	if (IsRegenBatched() && GetRegenSubsystem()->GetMana(GetAttributeSet(), Mana))
+	{
+		return Mana;
+	}
+	return GetAttributeSet()->GetCurrentMana();
 }
 
 void UFineCharacterGameplay::SetMana(float InMana)
@@ -392,7 +682,13 @@ void UFineCharacterGameplay::SetDefensePower(float InDefensePower)
 
 float UFineCharacterGameplay::GetStamina() const
 {
-	return GetAttributeSet()->GetStamina();
+	// Batched regeneration writes back to the attribute set only now and then.
+	float Stamina;
+	if (IsRegenBatched() && GetRegenSubsystem()->GetStamina(GetAttributeSet(), Stamina))
+	{
+		return Stamina;
+	}
+	return GetAttributeSet()->GetCurrentStamina();
 }
 
 void UFineCharacterGameplay::SetStamina(float InStamina)
@@ -404,6 +700,48 @@ void UFineCharacterGameplay::SetStamina(float InStamina)
 	}
 }
 
+void UFineCharacterGameplay::SetResourceDrainRates(float StaminaDrainRate, float ManaDrainRate)
+{
+	switch (ResourceRegenMode)
+	{
+	case EFineResourceRegenMode::Batched:
+		if (IsRegenBatched())
+		{
+			GetRegenSubsystem()->SetDrainRates(GetAttributeSet(), StaminaDrainRate, ManaDrainRate);
+		}
+		break;
+	case EFineResourceRegenMode::Continuous:
+		GetAttributeSet()->SetContinuousRate(UFineCharacterAttributeSet::GetStaminaAttribute(),
+		                                     StaminaRegenRate - StaminaDrainRate);
+		GetAttributeSet()->SetContinuousRate(UFineCharacterAttributeSet::GetManaAttribute(),
+		                                     ManaRegenRate - ManaDrainRate);
+		break;
+	case EFineResourceRegenMode::PeriodicEffect:
+		FP_VERBOSE("Drain rates are ignored with periodic effect regeneration.");
+		break;
+	}
+}
+
+void UFineCharacterGameplay::AddResourceDrainRates(float StaminaDrainDelta, float ManaDrainDelta)
+{
+	ActiveStaminaDrainRate = FMath::Max(ActiveStaminaDrainRate + StaminaDrainDelta, 0.f);
+	ActiveManaDrainRate = FMath::Max(ActiveManaDrainRate + ManaDrainDelta, 0.f);
+	SetResourceDrainRates(ActiveStaminaDrainRate, ActiveManaDrainRate);
+}
+
+bool UFineCharacterGameplay::IsResourceDrainLazy() const
+{
+	switch (ResourceRegenMode)
+	{
+	case EFineResourceRegenMode::Batched:
+		return IsRegenBatched();
+	case EFineResourceRegenMode::Continuous:
+		return IsValid(GetAttributeSet());
+	default:
+		return false;
+	}
+}
+
 float UFineCharacterGameplay::GetMaxStamina() const
 {
 	return GetAttributeSet()->GetMaxStamina();
@@ -420,25 +758,214 @@ void UFineCharacterGameplay::SetMaxStamina(float InMaxStamina)
 
 UFineCharacterAttributeSet* UFineCharacterGameplay::GetAttributeSet() const
 {
-	if (!AbilitySystemComponent.IsValid())
+	return CachedAttributeSet;
+}
+
+void UFineCharacterGameplay::ClearAllAbilities()
+{
+	TArray<FGameplayAbilitySpecHandle> Handles;
+	AbilityRegistry.GetHandles(Handles);
+	RevokeAbilities(Handles);
+	FP_LOG("All abilities cleared.");
+}
+
+void UFineCharacterGameplay::ResolveGameplayTags()
+{
+	AliveTag = FinePlayGameplayTags::ResolveTag(AliveGameplayTagName, FinePlayGameplayTags::Actor_State_Alive);
+	InvincibleTag = FinePlayGameplayTags::ResolveTag(InvincibleGameplayTagName,
+	                                                 FinePlayGameplayTags::Actor_State_Invincible);
+	JumpTag = FinePlayGameplayTags::ResolveTag(JumpGameplayTagName, FinePlayGameplayTags::Actor_State_Jumping);
+	RunTag = FinePlayGameplayTags::ResolveTag(RunGameplayTagName, FinePlayGameplayTags::Actor_State_Running);
+	MovingTag = FinePlayGameplayTags::ResolveTag(MovingGameplayTagName, FinePlayGameplayTags::Actor_State_Moving);
+	ExhaustedTag = FinePlayGameplayTags::ResolveTag(ExhaustedGameplayTagName,
+	                                                FinePlayGameplayTags::Actor_State_Exhausted);
+}
+
+void UFineCharacterGameplay::BindStateTagEvents(UAbilitySystemComponent* AbilitySystem)
+{
+	const TPair<FGameplayTag, EFineCharacterState> StateTags[] = {
+		{AliveTag, EFineCharacterState::Alive},
+		{InvincibleTag, EFineCharacterState::Invincible},
+		{MovingTag, EFineCharacterState::Moving},
+		{RunTag, EFineCharacterState::Running},
+		{JumpTag, EFineCharacterState::Jumping},
+		{ExhaustedTag, EFineCharacterState::Exhausted},
+	};
+	for (const auto& StateTag : StateTags)
 	{
-		return nullptr;
+		const auto Handle = AbilitySystem->RegisterGameplayTagEvent(
+			StateTag.Key, EGameplayTagEventType::NewOrRemoved).AddUObject(
+			this, &UFineCharacterGameplay::OnStateTagChanged, StateTag.Value);
+		StateTagEventHandles.Emplace(StateTag.Key, Handle);
+		// Pick up tags added before binding.
+		OnStateTagChanged(StateTag.Key, AbilitySystem->GetTagCount(StateTag.Key), StateTag.Value);
 	}
+}
 
-	auto AttributeSet = const_cast<UAttributeSet*>(AbilitySystemComponent->GetAttributeSet(AttributeSetClass));
-	return Cast<UFineCharacterAttributeSet>(AttributeSet);
+void UFineCharacterGameplay::UnbindStateTagEvents(UAbilitySystemComponent* AbilitySystem)
+{
+	if (IsValid(AbilitySystem))
+	{
+		for (const auto& Pair : StateTagEventHandles)
+		{
+			AbilitySystem->RegisterGameplayTagEvent(Pair.Key, EGameplayTagEventType::NewOrRemoved).Remove(Pair.Value);
+		}
+	}
+	StateTagEventHandles.Empty();
+	StateFlags.store(0, std::memory_order_relaxed);
 }
 
-void UFineCharacterGameplay::ClearAllAbilities()
+void UFineCharacterGameplay::OnStateTagChanged(const FGameplayTag Tag, int32 NewCount, EFineCharacterState State)
 {
-	const auto AbilitySystem = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(GetOwner());
-	for (const auto& Handle : AbilityHandles)
+	FineGameplayTagProfiler::FScopedListener ProfilerScope;
+	if (NewCount > 0)
 	{
-		AbilitySystem->ClearAbility(Handle);
+		StateFlags.fetch_or(static_cast<uint8>(State), std::memory_order_relaxed);
+	}
+	else
+	{
+		StateFlags.fetch_and(static_cast<uint8>(~static_cast<uint8>(State)), std::memory_order_relaxed);
+	}
+	MarkSnapshotDirty();
+}
+
+void UFineCharacterGameplay::MarkSnapshotDirty()
+{
+	if (bSnapshotDirty || !HasBegunPlay())
+	{
+		return;
+	}
+	bSnapshotDirty = true;
+	SetComponentTickEnabled(true);
+}
+
+void UFineCharacterGameplay::PublishSnapshot()
+{
+	bSnapshotDirty = false;
+	const auto AttributeSet = GetAttributeSet();
+	if (!IsValid(AttributeSet))
+	{
+		return;
+	}
+	FFineCharacterSnapshot Snapshot;
+	Snapshot.Health = AttributeSet->GetHealth();
+	Snapshot.MaxHealth = AttributeSet->GetMaxHealth();
+	Snapshot.Mana = GetMana();
+	Snapshot.MaxMana = AttributeSet->GetMaxMana();
+	Snapshot.MovementSpeed = AttributeSet->GetMovementSpeed();
+	Snapshot.MaxMovementSpeed = AttributeSet->GetMaxMovementSpeed();
+	Snapshot.AttackPower = AttributeSet->GetAttackPower();
+	Snapshot.DefensePower = AttributeSet->GetDefensePower();
+	Snapshot.Stamina = GetStamina();
+	Snapshot.MaxStamina = AttributeSet->GetMaxStamina();
+	Snapshot.StateFlags = StateFlags.load(std::memory_order_relaxed);
+	Snapshot.FrameNumber = GFrameCounter;
+	SnapshotBuffer.Publish(Snapshot);
+}
+
+void UFineCharacterGameplay::OnSnapshotAttributeChanged(const FOnAttributeChangeData& OnAttributeChangeData)
+{
+	if (IsRegenBatched())
+	{
+		const auto& Attribute = OnAttributeChangeData.Attribute;
+		if (Attribute == UFineCharacterAttributeSet::GetStaminaAttribute() ||
+			Attribute == UFineCharacterAttributeSet::GetMaxStaminaAttribute() ||
+			Attribute == UFineCharacterAttributeSet::GetManaAttribute() ||
+			Attribute == UFineCharacterAttributeSet::GetMaxManaAttribute())
+		{
+			GetRegenSubsystem()->SyncFromAttributeSet(GetAttributeSet());
+		}
+	}
+	MarkSnapshotDirty();
+}
+
+void UFineCharacterGameplay::CompileAbilityCancellationRules()
+{
+	const auto AbilitySystem = SetAndGetAbilitySystemComponent();
+	if (!IsValid(AbilitySystem))
+	{
+		return;
+	}
+	CancellationRules.Compile(AbilitySystem, AbilityRegistry);
+
+	// Listen only to the attributes some rule watches.
+	TArray<FGameplayAttribute> Attributes;
+	CancellationRules.GetAttributes(Attributes);
+	for (int32 Index = CancellationAttributeHandles.Num() - 1; Index >= 0; --Index)
+	{
+		const auto& Pair = CancellationAttributeHandles[Index];
+		if (Attributes.Remove(Pair.Key) == 0)
+		{
+			AbilitySystem->GetGameplayAttributeValueChangeDelegate(Pair.Key).Remove(Pair.Value);
+			CancellationAttributeHandles.RemoveAtSwap(Index);
+		}
+	}
+	for (const auto& Attribute : Attributes)
+	{
+		CancellationAttributeHandles.Emplace(Attribute, AbilitySystem->GetGameplayAttributeValueChangeDelegate(Attribute).
+		                                     AddUObject(this, &UFineCharacterGameplay::OnCancellationAttributeChanged));
+	}
+}
+
+void UFineCharacterGameplay::OnCancellationAttributeChanged(const FOnAttributeChangeData& OnAttributeChangeData)
+{
+	CancellationRules.Evaluate(AbilitySystemComponent.Get(), OnAttributeChangeData.Attribute,
+	                           OnAttributeChangeData.NewValue);
+}
+
+void UFineCharacterGameplay::OnCharacterMovementUpdated(float DeltaSeconds, FVector OldLocation, FVector OldVelocity)
+{
+	if (MovementStateSubsystem.IsValid())
+	{
+		MovementStateSubsystem->MarkMovementUpdated(MovementStateSlot);
+	}
+	if (FineInputLatency::bEnabled && !GetOwner()->GetVelocity().IsNearlyZero())
+	{
+		FineInputLatency::Mark(GetOwner(), EFineInputLatencyStage::Motion);
+	}
+}
+
+bool UFineCharacterGameplay::IsRegenBatched() const
+{
+	return ResourceRegenMode == EFineResourceRegenMode::Batched && IsValid(GetRegenSubsystem());
+}
+
+UFineResourceRegenSubsystem* UFineCharacterGameplay::GetRegenSubsystem() const
+{
+	return UFineResourceRegenSubsystem::Get(this);
+}
+
+UCapsuleComponent* UFineCharacterGameplay::GetOwnerCapsule() const
+{
+	if (!CachedCapsule.IsValid())
+	{
+		CacheOwnerComponents();
+	}
+	return CachedCapsule.Get();
+}
+
+UCharacterMovementComponent* UFineCharacterGameplay::GetOwnerCharacterMovement() const
+{
+	if (!CachedCharacterMovement.IsValid())
+	{
+		CacheOwnerComponents();
+	}
+	return CachedCharacterMovement.Get();
+}
+
+void UFineCharacterGameplay::CacheOwnerComponents() const
+{
+	const auto Owner = GetOwner();
+	if (const auto Character = Cast<ACharacter>(Owner))
+	{
+		CachedCapsule = Character->GetCapsuleComponent();
+		CachedCharacterMovement = Character->GetCharacterMovement();
+	}
+	else if (IsValid(Owner))
+	{
+		CachedCapsule = Owner->FindComponentByClass<UCapsuleComponent>();
+		CachedCharacterMovement = Owner->FindComponentByClass<UCharacterMovementComponent>();
 	}
-	// Clear the ability handles.
-	AbilityHandles.Empty();
-	FP_LOG("All abilities cleared.");
 }
 
 UAbilitySystemComponent* UFineCharacterGameplay::SetAndGetAbilitySystemComponent()
@@ -0,0 +1,190 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Actor/FineGroundProbe.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Diagnostics/FineTestWorld.h"
+#include "Engine/CollisionProfile.h"
+#include "Misc/AutomationTest.h"
+#endif
+
+void FFineGroundProbe::Configure(int32 RingSampleCount, float InRadius, float InMaxDistance, bool bInAsync)
+{
+	RingSampleCount = FMath::Max(RingSampleCount, 3);
+	Radius = FMath::Max(InRadius, UE_KINDA_SMALL_NUMBER);
+	MaxDistance = InMaxDistance;
+	bAsync = bInAsync;
+	Samples.SetNum(1 + RingSampleCount);
+	AsyncTraces.SetNum(bAsync ? Samples.Num() : 0);
+	Samples[0].Offset = FVector::ZeroVector;
+	for (int32 Index = 0; Index < RingSampleCount; ++Index)
+	{
+		const auto Angle = UE_TWO_PI * Index / RingSampleCount;
+		Samples[1 + Index].Offset = FVector(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, 0.f);
+	}
+	Reset();
+}
+
+void FFineGroundProbe::Update(const AActor* Owner, float CapsuleHalfHeight)
+{
+	const auto World = IsValid(Owner) ? Owner->GetWorld() : nullptr;
+	if (!IsValid(World) || Samples.IsEmpty())
+	{
+		return;
+	}
+	const auto Location = Owner->GetActorLocation();
+	if (SampledFrame == GFrameCounter && SampledLocation.Equals(Location))
+	{
+		return;
+	}
+	SampledFrame = GFrameCounter;
+	SampledLocation = Location;
+	for (int32 Index = 0; Index < Samples.Num(); ++Index)
+	{
+		Trace(World, Owner, Index, CapsuleHalfHeight);
+	}
+}
+
+bool FFineGroundProbe::GetSample(const FVector& Offset, FFineGroundSample& OutSample) const
+{
+	// Traces start at the actor's height. A raised or lowered start can hit other geometry, so trace it instead.
+	if (Samples.IsEmpty() || !FMath::IsNearlyZero(Offset.Z, UE_KINDA_SMALL_NUMBER))
+	{
+		return false;
+	}
+	const auto RingSampleCount = Samples.Num() - 1;
+	const auto OffsetDistance = Offset.Size2D();
+	// Small tolerance so queries exactly on the ring are answered.
+	if (OffsetDistance > Radius * (1.f + UE_KINDA_SMALL_NUMBER))
+	{
+		return false;
+	}
+	const auto& Center = Samples[0];
+	if (OffsetDistance <= UE_KINDA_SMALL_NUMBER)
+	{
+		OutSample = Center;
+		return true;
+	}
+
+	// Between the two ring samples around the offset's direction, then between the center and the ring.
+	const auto Step = UE_TWO_PI / RingSampleCount;
+	auto Angle = FMath::Atan2(Offset.Y, Offset.X);
+	if (Angle < 0.f)
+	{
+		Angle += UE_TWO_PI;
+	}
+	const auto RingPosition = Angle / Step;
+	const auto First = FMath::FloorToInt(RingPosition) % RingSampleCount;
+	const auto Second = (First + 1) % RingSampleCount;
+	const auto& A = Samples[1 + First];
+	const auto& B = Samples[1 + Second];
+	const auto RingAlpha = static_cast<float>(RingPosition - FMath::FloorToDouble(RingPosition));
+	const auto RadialAlpha = FMath::Min(OffsetDistance / Radius, 1.f);
+
+	const auto RingDistance = FMath::Lerp(A.Distance, B.Distance, RingAlpha);
+	const auto RingNormal = FMath::Lerp(A.Normal, B.Normal, RingAlpha);
+	OutSample.Offset = FVector(Offset.X, Offset.Y, 0.f);
+	OutSample.Distance = FMath::Lerp(Center.Distance, RingDistance, RadialAlpha);
+	OutSample.Normal = FMath::Lerp(Center.Normal, RingNormal, RadialAlpha).GetSafeNormal(UE_SMALL_NUMBER,
+		FVector::UpVector);
+	// Surface and hit can't be blended, take the nearest sample's.
+	const auto& Nearest = RadialAlpha < 0.5f ? Center : RingAlpha < 0.5f ? A : B;
+	OutSample.Surface = Nearest.Surface;
+	OutSample.bHit = Nearest.bHit;
+	return true;
+}
+
+void FFineGroundProbe::Reset()
+{
+	SampledFrame = 0;
+	for (auto& AsyncTrace : AsyncTraces)
+	{
+		AsyncTrace.Reset();
+	}
+}
+
+void FFineGroundProbe::Trace(UWorld* World, const AActor* Owner, int32 Index, float CapsuleHalfHeight)
+{
+	auto& Sample = Samples[Index];
+	const auto Start = Owner->GetActorLocation() + Sample.Offset;
+	const auto End = Start - Owner->GetActorUpVector() * MaxDistance;
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(FineGroundProbe), false, Owner);
+	Params.bReturnPhysicalMaterial = true;
+	FHitResult Hit;
+	bool bHit = false;
+	// The character moves little in a frame, so the previous frame's trace answers this one.
+	if (!bAsync || !AsyncTraces[Index].Consume(World, Hit, bHit))
+	{
+		bHit = World->LineTraceSingleByChannel(Hit, Start, End, ECC_Visibility, Params);
+	}
+	if (bAsync)
+	{
+		AsyncTraces[Index].Request(World, Start, End, ECC_Visibility, Params);
+	}
+	Sample.bHit = bHit;
+	Sample.Distance = bHit ? Hit.Distance - CapsuleHalfHeight : MaxDistance;
+	Sample.Normal = bHit ? FVector(Hit.ImpactNormal) : FVector::UpVector;
+	Sample.Surface = bHit ? Hit.PhysMaterial : nullptr;
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFineGroundProbeTest, "FinePlay.Actor.GroundProbe",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+/// Ground distances from the probe match direct traces, also for offsets with a vertical part.
+bool FFineGroundProbeTest::RunTest(const FString& Parameters)
+{
+	const FFineTestWorld World;
+	const auto Floor = World.Get()->SpawnActor<AActor>();
+	const auto FloorBox = NewObject<UBoxComponent>(Floor, TEXT("Floor"));
+	FloorBox->SetBoxExtent(FVector(1000.f, 1000.f, 10.f));
+	FloorBox->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	Floor->SetRootComponent(FloorBox);
+	FloorBox->RegisterComponent();
+
+	const auto Character = World.SpawnCharacter(FVector(0.f, 0.f, 200.f));
+	const auto CharacterGameplay = UFineCharacterGameplay::FindCharacterGameplay(Character);
+	if (!TestNotNull(TEXT("Character gameplay"), CharacterGameplay))
+	{
+		return false;
+	}
+	// Let the floor enter the physics scene.
+	World.Tick(0.01f);
+
+	const auto ExpectedDistance = [&](const FVector& Offset)
+	{
+		const auto Start = Character->GetActorLocation() + Offset;
+		FHitResult Hit;
+		const FCollisionQueryParams Params(SCENE_QUERY_STAT(FineGroundProbeTest), false, Character);
+		return World.Get()->LineTraceSingleByChannel(Hit, Start, Start - FVector::UpVector * 1000.f, ECC_Visibility,
+		                                             Params)
+			       ? Hit.Distance - Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight()
+			       : 1000.f;
+	};
+
+	const FVector Horizontal(3.f, 0.f, 0.f);
+	FFineGroundSample Sample;
+	TestTrue(TEXT("Horizontal offset is sampled"), CharacterGameplay->GetGroundSample(Horizontal, Sample));
+	TestEqual(TEXT("Horizontal distance"), CharacterGameplay->GetDistanceFromGroundStaticMesh(Horizontal),
+	          ExpectedDistance(Horizontal), 0.01f);
+
+	for (const auto& Offset : {FVector(3.f, 0.f, 10.f), FVector(3.f, 0.f, -10.f), FVector(0.f, 0.f, 10.f)})
+	{
+		TestFalse(*FString::Printf(TEXT("%s isn't sampled"), *Offset.ToString()),
+		          CharacterGameplay->GetGroundSample(Offset, Sample));
+		TestEqual(*FString::Printf(TEXT("Distance at %s"), *Offset.ToString()),
+		          CharacterGameplay->GetDistanceFromGroundStaticMesh(Offset), ExpectedDistance(Offset), 0.01f);
+	}
+	TestEqual(TEXT("Raised offset"), CharacterGameplay->GetDistanceFromGroundStaticMesh(FVector(3.f, 0.f, 10.f)),
+	          CharacterGameplay->GetDistanceFromGroundStaticMesh(Horizontal) + 10.f, 0.01f);
+	return true;
+}
+
+#endif
@@ -0,0 +1,136 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Actor/FineMovementStateSubsystem.h"
+
+#include "FinePlayLog.h"
+#include "Diagnostics/FineGameplayTagProfiler.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+static TAutoConsoleVariable<float> CVarFinePlayMovementStartSpeed(
+	TEXT("FinePlay.MovementState.StartSpeed"), 1.f,
+	TEXT("Speed in cm/s above which a standing character is considered moving."));
+
+static TAutoConsoleVariable<float> CVarFinePlayMovementStopSpeed(
+	TEXT("FinePlay.MovementState.StopSpeed"), 0.1f,
+	TEXT("Speed in cm/s below which a moving character is considered standing. Keep below StartSpeed."));
+
+int32 UFineMovementStateSubsystem::Register(UCharacterMovementComponent* Movement,
+                                            UAbilitySystemComponent* AbilitySystem, const FGameplayTag& MovingTag,
+                                            bool bMoving)
+{
+	if (!IsValid(Movement) || !IsValid(AbilitySystem) || !MovingTag.IsValid())
+	{
+		return INDEX_NONE;
+	}
+	int32 Slot;
+	if (FreeSlots.Num() > 0)
+	{
+		Slot = FreeSlots.Pop(EAllowShrinking::No);
+	}
+	else
+	{
+		Slot = Movements.AddDefaulted();
+		AbilitySystems.AddDefaulted();
+		MovingTags.AddDefaulted();
+		Moving.Add(false);
+		Queued.Add(false);
+	}
+	Movements[Slot] = Movement;
+	AbilitySystems[Slot] = AbilitySystem;
+	MovingTags[Slot] = MovingTag;
+	Moving[Slot] = bMoving;
+	// Evaluate once even if the movement component doesn't update until it moves.
+	MarkMovementUpdated(Slot);
+	return Slot;
+}
+
+void UFineMovementStateSubsystem::Unregister(int32 Slot)
+{
+	// The tag is valid only while the slot is registered.
+	if (!MovingTags.IsValidIndex(Slot) || !MovingTags[Slot].IsValid())
+	{
+		return;
+	}
+	SetMoving(Slot, false);
+	Movements[Slot] = nullptr;
+	AbilitySystems[Slot] = nullptr;
+	MovingTags[Slot] = FGameplayTag();
+	// Queued stays set until the pass skips the slot, so it isn't queued twice.
+	FreeSlots.Add(Slot);
+}
+
+UFineMovementStateSubsystem* UFineMovementStateSubsystem::Get(const UObject* WorldContextObject)
+{
+	const auto World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return IsValid(World) ? World->GetSubsystem<UFineMovementStateSubsystem>() : nullptr;
+}
+
+void UFineMovementStateSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Queue.IsEmpty())
+	{
+		return;
+	}
+	const auto StartSpeedSquared = FMath::Square(CVarFinePlayMovementStartSpeed.GetValueOnGameThread());
+	const auto StopSpeedSquared = FMath::Square(CVarFinePlayMovementStopSpeed.GetValueOnGameThread());
+	// Tag listeners may move characters, which queues them for the next pass.
+	Swap(Queue, Processing);
+	for (const auto Slot : Processing)
+	{
+		Queued[Slot] = false;
+		const auto Movement = Movements[Slot].Get();
+		if (!IsValid(Movement))
+		{
+			continue;
+		}
+		const auto SpeedSquared = Movement->Velocity.SizeSquared();
+		SetMoving(Slot, Moving[Slot] ? SpeedSquared > StopSpeedSquared : SpeedSquared > StartSpeedSquared);
+	}
+	Processing.Reset();
+}
+
+TStatId UFineMovementStateSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFineMovementStateSubsystem, STATGROUP_Tickables);
+}
+
+void UFineMovementStateSubsystem::Deinitialize()
+{
+	Movements.Empty();
+	AbilitySystems.Empty();
+	MovingTags.Empty();
+	Moving.Empty();
+	Queued.Empty();
+	FreeSlots.Empty();
+	Queue.Empty();
+	Processing.Empty();
+	Super::Deinitialize();
+}
+
+void UFineMovementStateSubsystem::SetMoving(int32 Slot, bool bMoving)
+{
+	if (Moving[Slot] == bMoving)
+	{
+		return;
+	}
+	Moving[Slot] = bMoving;
+	const auto AbilitySystem = AbilitySystems[Slot].Get();
+	if (!IsValid(AbilitySystem))
+	{
+		return;
+	}
+	if (bMoving)
+	{
+		FineGameplayTagProfiler::AddLooseTag(AbilitySystem, MovingTags[Slot]);
+		FP_VERBOSE("Adding moving tag to %s.", *GetNameSafe(AbilitySystem->GetOwnerActor()));
+	}
+	else
+	{
+		FineGameplayTagProfiler::RemoveLooseTag(AbilitySystem, MovingTags[Slot]);
+		FP_VERBOSE("Removing moving tag from %s.", *GetNameSafe(AbilitySystem->GetOwnerActor()));
+	}
+}
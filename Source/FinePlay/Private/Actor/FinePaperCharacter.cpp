@@ -14,6 +14,12 @@ AFinePaperCharacter::AFinePaperCharacter(): Super()
 	AbilitySystemComponent->SetIsReplicated(true);
 }
 
+void AFinePaperCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	CharacterGameplay = FindComponentByClass<UFineCharacterGameplay>();
+}
+
 void AFinePaperCharacter::BeginPlay()
 {
 	Super::BeginPlay();
@@ -0,0 +1,250 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Actor/FineResourceRegenSubsystem.h"
+
+#include "FinePlayLog.h"
+#include "Actor/FineCharacterAttributeSet.h"
+#include "Diagnostics/FinePlayStats.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+
+static TAutoConsoleVariable<float> CVarFinePlayRegenFixedStep(
+	TEXT("FinePlay.Regen.FixedStep"), 0.f,
+	TEXT("Fixed time step in seconds for batched stamina and mana regeneration. 0 advances once per frame."));
+
+static TAutoConsoleVariable<float> CVarFinePlayRegenWriteBackInterval(
+	TEXT("FinePlay.Regen.WriteBackInterval"), 0.5f,
+	TEXT("Seconds between writing batched stamina and mana back to attribute sets, besides reaching empty or full."));
+
+static TAutoConsoleVariable<int32> CVarFinePlayRegenParallelThreshold(
+	TEXT("FinePlay.Regen.ParallelThreshold"), 128,
+	TEXT("Minimum number of characters to advance regeneration in parallel."));
+
+namespace FineResourceRegen
+{
+	/// Advances the value and returns true if it reached empty or full, or left empty.
+	FORCEINLINE bool Advance(float& Value, const float MaxValue, const float Rate, const float Time)
+	{
+		const auto OldValue = Value;
+		Value = FMath::Clamp(Value + Rate * Time, 0.f, MaxValue);
+		return (OldValue < MaxValue && Value >= MaxValue) || (OldValue > 0.f && Value <= 0.f) ||
+			(OldValue <= 0.f && Value > 0.f);
+	}
+}
+
+void UFineResourceRegenSubsystem::Register(UFineCharacterAttributeSet* AttributeSet, float InStaminaRegenRate,
+                                           float InManaRegenRate)
+{
+	if (!IsValid(AttributeSet) || IsRegistered(AttributeSet))
+	{
+		return;
+	}
+	const auto Index = AttributeSets.Add(AttributeSet);
+	Keys.Add(FObjectKey(AttributeSet));
+	Indices.Add(Keys[Index], Index);
+	Stamina.Add(AttributeSet->GetStamina());
+	MaxStamina.Add(AttributeSet->GetMaxStamina());
+	StaminaRegenRate.Add(InStaminaRegenRate);
+	StaminaDrainRate.Add(0.f);
+	WrittenStamina.Add(AttributeSet->GetStamina());
+	Mana.Add(AttributeSet->GetMana());
+	MaxMana.Add(AttributeSet->GetMaxMana());
+	ManaRegenRate.Add(InManaRegenRate);
+	ManaDrainRate.Add(0.f);
+	WrittenMana.Add(AttributeSet->GetMana());
+	CrossedThreshold.Add(false);
+}
+
+void UFineResourceRegenSubsystem::Unregister(UFineCharacterAttributeSet* AttributeSet)
+{
+	if (const auto Index = Indices.Find(FObjectKey(AttributeSet)))
+	{
+		// Don't lose what was regenerated since the last write back.
+		WriteBackAt(*Index);
+		RemoveAt(*Index);
+	}
+}
+
+void UFineResourceRegenSubsystem::SetDrainRates(const UFineCharacterAttributeSet* AttributeSet,
+                                                float InStaminaDrainRate, float InManaDrainRate)
+{
+	if (const auto Index = Indices.Find(FObjectKey(AttributeSet)))
+	{
+		StaminaDrainRate[*Index] = InStaminaDrainRate;
+		ManaDrainRate[*Index] = InManaDrainRate;
+	}
+}
+
+void UFineResourceRegenSubsystem::SyncFromAttributeSet(const UFineCharacterAttributeSet* AttributeSet)
+{
+	if (bWritingBack)
+	{
+		return;
+	}
+	if (const auto Index = Indices.Find(FObjectKey(AttributeSet)))
+	{
+		Stamina[*Index] = WrittenStamina[*Index] = AttributeSet->GetStamina();
+		MaxStamina[*Index] = AttributeSet->GetMaxStamina();
+		Mana[*Index] = WrittenMana[*Index] = AttributeSet->GetMana();
+		MaxMana[*Index] = AttributeSet->GetMaxMana();
+	}
+}
+
+void UFineResourceRegenSubsystem::WriteBack(const UFineCharacterAttributeSet* AttributeSet)
+{
+	if (const auto Index = Indices.Find(FObjectKey(AttributeSet)))
+	{
+		WriteBackAt(*Index);
+	}
+}
+
+bool UFineResourceRegenSubsystem::GetStamina(const UFineCharacterAttributeSet* AttributeSet, float& OutStamina) const
+{
+	if (const auto Index = Indices.Find(FObjectKey(AttributeSet)))
+	{
+		OutStamina = Stamina[*Index];
+		return true;
+	}
+	return false;
+}
+
+bool UFineResourceRegenSubsystem::GetMana(const UFineCharacterAttributeSet* AttributeSet, float& OutMana) const
+{
+	if (const auto Index = Indices.Find(FObjectKey(AttributeSet)))
+	{
+		OutMana = Mana[*Index];
+		return true;
+	}
+	return false;
+}
+
+UFineResourceRegenSubsystem* UFineResourceRegenSubsystem::Get(const UObject* WorldContextObject)
+{
+	const auto World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return IsValid(World) ? World->GetSubsystem<UFineResourceRegenSubsystem>() : nullptr;
+}
+
+void UFineResourceRegenSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	FP_SCOPE_CYCLE(ResourceRegen);
+
+	const auto Num = AttributeSets.Num();
+	if (Num == 0)
+	{
+		return;
+	}
+	auto StepTime = DeltaTime;
+	const auto FixedStep = CVarFinePlayRegenFixedStep.GetValueOnGameThread();
+	if (FixedStep > 0.f)
+	{
+		StepAccumulator += DeltaTime;
+		const auto Steps = FMath::FloorToInt(StepAccumulator / FixedStep);
+		if (Steps == 0)
+		{
+			return;
+		}
+		StepTime = Steps * FixedStep;
+		StepAccumulator -= StepTime;
+	}
+	WriteBackElapsed += StepTime;
+	const auto bWriteBackAll = WriteBackElapsed >= CVarFinePlayRegenWriteBackInterval.GetValueOnGameThread();
+	if (bWriteBackAll)
+	{
+		WriteBackElapsed = 0.f;
+	}
+
+	// Pure math on plain arrays, no UObject access.
+	const auto Flags = Num < CVarFinePlayRegenParallelThreshold.GetValueOnGameThread()
+		                   ? EParallelForFlags::ForceSingleThread
+		                   : EParallelForFlags::None;
+	ParallelFor(Num, [this, StepTime](int32 Index)
+	{
+		const auto bStaminaCrossed = FineResourceRegen::Advance(
+			Stamina[Index], MaxStamina[Index], StaminaRegenRate[Index] - StaminaDrainRate[Index], StepTime);
+		const auto bManaCrossed = FineResourceRegen::Advance(
+			Mana[Index], MaxMana[Index], ManaRegenRate[Index] - ManaDrainRate[Index], StepTime);
+		CrossedThreshold[Index] = bStaminaCrossed || bManaCrossed;
+	}, Flags);
+
+	for (int32 Index = Num - 1; Index >= 0; --Index)
+	{
+		if (!AttributeSets[Index].IsValid())
+		{
+			RemoveAt(Index);
+			continue;
+		}
+		if (CrossedThreshold[Index] || bWriteBackAll)
+		{
+			WriteBackAt(Index);
+		}
+	}
+}
+
+TStatId UFineResourceRegenSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFineResourceRegenSubsystem, STATGROUP_Tickables);
+}
+
+void UFineResourceRegenSubsystem::Deinitialize()
+{
+	Indices.Empty();
+	Keys.Empty();
+	AttributeSets.Empty();
+	Stamina.Empty();
+	MaxStamina.Empty();
+	StaminaRegenRate.Empty();
+	StaminaDrainRate.Empty();
+	WrittenStamina.Empty();
+	Mana.Empty();
+	MaxMana.Empty();
+	ManaRegenRate.Empty();
+	ManaDrainRate.Empty();
+	WrittenMana.Empty();
+	CrossedThreshold.Empty();
+	Super::Deinitialize();
+}
+
+void UFineResourceRegenSubsystem::WriteBackAt(int32 Index)
+{
+	const auto AttributeSet = AttributeSets[Index].Get();
+	if (!IsValid(AttributeSet))
+	{
+		return;
+	}
+	TGuardValue<bool> WritingBackGuard(bWritingBack, true);
+	if (Stamina[Index] != WrittenStamina[Index])
+	{
+		WrittenStamina[Index] = Stamina[Index];
+		AttributeSet->SetStamina(Stamina[Index]);
+	}
+	if (Mana[Index] != WrittenMana[Index])
+	{
+		WrittenMana[Index] = Mana[Index];
+		AttributeSet->SetMana(Mana[Index]);
+	}
+}
+
+void UFineResourceRegenSubsystem::RemoveAt(int32 Index)
+{
+	const auto LastIndex = AttributeSets.Num() - 1;
+	Indices.Remove(Keys[Index]);
+	if (Index != LastIndex)
+	{
+		Indices.Add(Keys[LastIndex], Index);
+	}
+	Keys.RemoveAtSwap(Index);
+	AttributeSets.RemoveAtSwap(Index);
+	Stamina.RemoveAtSwap(Index);
+	MaxStamina.RemoveAtSwap(Index);
+	StaminaRegenRate.RemoveAtSwap(Index);
+	StaminaDrainRate.RemoveAtSwap(Index);
+	WrittenStamina.RemoveAtSwap(Index);
+	Mana.RemoveAtSwap(Index);
+	MaxMana.RemoveAtSwap(Index);
+	ManaRegenRate.RemoveAtSwap(Index);
+	ManaDrainRate.RemoveAtSwap(Index);
+	WrittenMana.RemoveAtSwap(Index);
+	CrossedThreshold.RemoveAtSwap(Index);
+}
@@ -0,0 +1,307 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Control/FineClickToMoveComponent.h"
+
+#include "FinePlayLog.h"
+#include "NavigationSystem.h"
+#include "Diagnostics/FineInputLatency.h"
+#include "Diagnostics/FinePlayStats.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/Pawn.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "NavFilters/NavigationQueryFilter.h"
+#include "TimerManager.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+#include "Diagnostics/FineTestWorld.h"
+#include "Misc/AutomationTest.h"
+#endif
+
+UFineClickToMoveComponent::UFineClickToMoveComponent(): Super()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UFineClickToMoveComponent::RequestMoveTo(const FVector& Destination)
+{
+	if (TryRepairPath(Destination))
+	{
+		// A newer destination supersedes anything still queued.
+		CancelPendingRequests();
+		return;
+	}
+	QueuedDestination = Destination;
+	bHasQueuedDestination = true;
+	IssueQueuedRequest();
+}
+
+void UFineClickToMoveComponent::CancelPendingRequests()
+{
+	if (IsQueryPending())
+	{
+		if (const auto NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+		{
+			NavSys->AbortAsyncFindPathRequest(PendingQueryID);
+		}
+		PendingQueryID = INVALID_NAVQUERYID;
+	}
+	bHasQueuedDestination = false;
+	GetWorld()->GetTimerManager().ClearTimer(ThrottleTimerHandle);
+}
+
+void UFineClickToMoveComponent::StopMovement()
+{
+	CancelPendingRequests();
+	CurrentPath.Reset();
+}
+
+UFineClickToMoveComponent* UFineClickToMoveComponent::Get(const AController* Controller)
+{
+	return IsValid(Controller) ? Controller->FindComponentByClass<UFineClickToMoveComponent>() : nullptr;
+}
+
+void UFineClickToMoveComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopMovement();
+	if (IsValid(PathFollowing))
+	{
+		PathFollowing->OnRequestFinished.RemoveAll(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+bool UFineClickToMoveComponent::TryRepairPath(const FVector& Destination)
+{
+	if (!CurrentPath.IsValid() || !CurrentPath->IsValid() || IsQueryPending() ||
+		FVector::DistSquared(CurrentDestination, Destination) > FMath::Square(RepairRadius))
+	{
+		return false;
+	}
+	const auto Controller = Cast<AController>(GetOwner());
+	const auto Pawn = IsValid(Controller) ? Controller->GetPawn() : nullptr;
+	if (!IsValid(Pawn))
+	{
+		return false;
+	}
+	const auto RepairedPath = MakeRepairedPath(*CurrentPath, Pawn->GetNavAgentLocation(), Destination,
+	                                           RepairMaxDeviation);
+	if (!RepairedPath.IsValid())
+	{
+		return false;
+	}
+	// The new end must be reachable in a straight line on the navmesh.
+	const auto& Points = RepairedPath->GetPathPoints();
+	FVector HitLocation;
+	if (UNavigationSystemV1::NavigationRaycast(this, Points[Points.Num() - 2].Location, Destination, HitLocation,
+	                                           nullptr, Controller))
+	{
+		return false;
+	}
+	RepairedPath->SetNavigationDataUsed(CurrentPath->GetNavigationDataUsed());
+	FollowPath(RepairedPath, Destination);
+	return true;
+}
+
+FNavPathSharedPtr UFineClickToMoveComponent::MakeRepairedPath(const FNavigationPath& Path,
+                                                             const FVector& PawnLocation, const FVector& Destination,
+                                                             float MaxDeviation)
+{
+	const auto& Points = Path.GetPathPoints();
+	if (Points.Num() < 2)
+	{
+		return nullptr;
+	}
+	// Keep the corridor from the segment the pawn is on, without the old end.
+	int32 NearestSegment = 0;
+	auto NearestDistanceSquared = TNumericLimits<double>::Max();
+	for (int32 Index = 0; Index + 1 < Points.Num(); ++Index)
+	{
+		const auto DistanceSquared = FMath::PointDistToSegmentSquared(PawnLocation, Points[Index].Location,
+		                                                               Points[Index + 1].Location);
+		if (DistanceSquared < NearestDistanceSquared)
+		{
+			NearestDistanceSquared = DistanceSquared;
+			NearestSegment = Index;
+		}
+	}
+	// The pawn left the corridor, e.g. pushed away or moved by other means.
+	if (NearestDistanceSquared > FMath::Square(MaxDeviation))
+	{
+		return nullptr;
+	}
+	TArray<FVector> Corridor;
+	Corridor.Reserve(Points.Num() - NearestSegment + 1);
+	Corridor.Add(PawnLocation);
+	for (int32 Index = NearestSegment + 1; Index < Points.Num() - 1; ++Index)
+	{
+		Corridor.Add(Points[Index].Location);
+	}
+	Corridor.Add(Destination);
+	// World locations without a base, like found paths. A base would move the points along with it.
+	return MakeShared<FNavigationPath, ESPMode::ThreadSafe>(Corridor, nullptr);
+}
+
+void UFineClickToMoveComponent::IssueQueuedRequest()
+{
+	if (!bHasQueuedDestination || IsQueryPending())
+	{
+		// Issued again once the running query finished.
+		return;
+	}
+	auto& TimerManager = GetWorld()->GetTimerManager();
+	const auto Now = GetWorld()->GetTimeSeconds();
+	const auto Wait = LastRequestTime + MinRequestInterval - Now;
+	if (Wait > 0.0)
+	{
+		if (!TimerManager.IsTimerActive(ThrottleTimerHandle))
+		{
+			TimerManager.SetTimer(ThrottleTimerHandle, this, &UFineClickToMoveComponent::IssueQueuedRequest, Wait);
+		}
+		return;
+	}
+
+	const auto Controller = Cast<AController>(GetOwner());
+	const auto Pawn = IsValid(Controller) ? Controller->GetPawn() : nullptr;
+	const auto NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (!IsValid(Pawn) || !IsValid(NavSys))
+	{
+		bHasQueuedDestination = false;
+		return;
+	}
+	const auto& AgentProperties = Controller->GetNavAgentPropertiesRef();
+	const auto NavData = NavSys->GetNavDataForProps(AgentProperties, Pawn->GetNavAgentLocation());
+	if (!IsValid(NavData))
+	{
+		FP_WARNING("No navigation data for click to move.");
+		bHasQueuedDestination = false;
+		return;
+	}
+	FP_SCOPE_CYCLE(MovementInput);
+	bHasQueuedDestination = false;
+	LastRequestTime = Now;
+	PendingQueryDestination = QueuedDestination;
+	const FPathFindingQuery Query(Controller, *NavData, Pawn->GetNavAgentLocation(), QueuedDestination,
+	                              UNavigationQueryFilter::GetQueryFilter(*NavData, Controller, nullptr));
+	PendingQueryID = NavSys->FindPathAsync(AgentProperties, Query,
+	                                       FNavPathQueryDelegate::CreateUObject(
+		                                       this, &UFineClickToMoveComponent::OnPathFound));
+}
+
+void UFineClickToMoveComponent::OnPathFound(uint32 QueryID, ENavigationQueryResult::Type Result,
+                                            FNavPathSharedPtr Path)
+{
+	if (QueryID != PendingQueryID)
+	{
+		return;
+	}
+	PendingQueryID = INVALID_NAVQUERYID;
+	if (Result == ENavigationQueryResult::Success && Path.IsValid())
+	{
+		FollowPath(Path, PendingQueryDestination);
+	}
+	else
+	{
+		FP_INPUT_VERBOSE("Click to move path query failed: %d", static_cast<int32>(Result));
+	}
+	// Destinations clicked meanwhile.
+	IssueQueuedRequest();
+}
+
+void UFineClickToMoveComponent::FollowPath(const FNavPathSharedPtr& Path, const FVector& Destination)
+{
+	const auto Follower = GetPathFollowing();
+	if (!IsValid(Follower) || !Follower->IsPathFollowingAllowed())
+	{
+		return;
+	}
+	// Same as UAIBlueprintHelperLibrary::SimpleMoveToLocation, with the path found beforehand.
+	const auto bAlreadyAtGoal = Follower->HasReached(Destination, EPathFollowingReachMode::OverlapAgent);
+	if (Follower->GetStatus() != EPathFollowingStatus::Idle)
+	{
+		Follower->AbortMove(*this, FPathFollowingResultFlags::ForcedScript | FPathFollowingResultFlags::NewRequest,
+		                    FAIRequestID::AnyRequest,
+		                    bAlreadyAtGoal ? EPathFollowingVelocityMode::Reset : EPathFollowingVelocityMode::Keep);
+	}
+	CurrentPath = Path;
+	CurrentDestination = Destination;
+	if (bAlreadyAtGoal)
+	{
+		Follower->RequestMoveWithImmediateFinish(EPathFollowingResult::Success);
+		return;
+	}
+	Path->SetIgnoreInvalidation(true);
+	Follower->RequestMove(FAIMoveRequest(Destination), Path);
+	if (const auto Controller = Cast<AController>(GetOwner()))
+	{
+		FineInputLatency::Mark(Controller->GetPawn(), EFineInputLatencyStage::Applied);
+	}
+}
+
+void UFineClickToMoveComponent::OnMoveFinished(FAIRequestID RequestID, const FPathFollowingResult& Result)
+{
+	// Arrived, aborted or replaced by a move that isn't ours. Only a path being followed can be repaired.
+	CurrentPath.Reset();
+}
+
+UPathFollowingComponent* UFineClickToMoveComponent::GetPathFollowing()
+{
+	if (IsValid(PathFollowing))
+	{
+		return PathFollowing;
+	}
+	const auto Controller = Cast<AController>(GetOwner());
+	if (!IsValid(Controller))
+	{
+		return nullptr;
+	}
+	PathFollowing = Controller->FindComponentByClass<UPathFollowingComponent>();
+	if (!IsValid(PathFollowing))
+	{
+		PathFollowing = NewObject<UPathFollowingComponent>(Controller);
+		PathFollowing->RegisterComponentWithWorld(GetWorld());
+		PathFollowing->Initialize();
+	}
+	PathFollowing->OnRequestFinished.AddUObject(this, &UFineClickToMoveComponent::OnMoveFinished);
+	return PathFollowing;
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFineClickToMoveRepairTest, "FinePlay.Control.ClickToMove.RepairPath",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+/// A repaired path keeps its world points while the pawn walks along it.
+bool FFineClickToMoveRepairTest::RunTest(const FString& Parameters)
+{
+	const FFineTestWorld World;
+	const auto Pawn = World.SpawnCharacter(FVector(50.f, 0.f, 100.f));
+	const FNavigationPath Path(TArray<FVector>{
+		FVector(0.f, 0.f, 100.f), FVector(500.f, 0.f, 100.f), FVector(500.f, 500.f, 100.f)
+	});
+	const FVector Destination(550.f, 500.f, 100.f);
+
+	const auto RepairedPath = UFineClickToMoveComponent::MakeRepairedPath(Path, Pawn->GetActorLocation(),
+	                                                                      Destination, 50.f);
+	if (!TestTrue(TEXT("Repaired"), RepairedPath.IsValid()))
+	{
+		return false;
+	}
+	const TArray<FVector> Expected = {Pawn->GetActorLocation(), FVector(500.f, 0.f, 100.f), Destination};
+	TestEqual(TEXT("Point count"), RepairedPath->GetPathPoints().Num(), Expected.Num());
+	TestNull(TEXT("Base"), RepairedPath->GetBaseActor().Get());
+
+	Pawn->SetActorLocation(FVector(300.f, 0.f, 100.f));
+	for (int32 Index = 0; Index < FMath::Min(Expected.Num(), RepairedPath->GetPathPoints().Num()); ++Index)
+	{
+		TestEqual(*FString::Printf(TEXT("World point %d after moving"), Index),
+		          *RepairedPath->GetPathPointLocation(Index), Expected[Index]);
+	}
+
+	TestFalse(TEXT("Pawn off the corridor"),
+	          UFineClickToMoveComponent::MakeRepairedPath(Path, FVector(250.f, 200.f, 100.f), Destination, 50.f).
+	          IsValid());
+	return true;
+}
+
+#endif
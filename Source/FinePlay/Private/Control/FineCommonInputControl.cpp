@@ -6,6 +6,8 @@
 #include "EnhancedInputSubsystems.h"
 #include "FinePlayLog.h"
 #include "Actor/FineCharacterGameplay.h"
+#include "Diagnostics/FineInputReplay.h"
+#include "GameFramework/Character.h"
 
 
 UFineCommonInputControl::UFineCommonInputControl(): Super()
@@ -117,51 +119,97 @@ void UFineCommonInputControl::Deactivate()
 	Super::Deactivate();
 }
 
+void UFineCommonInputControl::ReplayInputEvent(EFineInputEvent Event, const FVector3f& Value)
+{
+	switch (Event)
+	{
+	case EFineInputEvent::InputStarted:
+		OnInputStarted();
+		break;
+	case EFineInputEvent::InteractTriggered:
+		OnInteractTriggered();
+		break;
+	case EFineInputEvent::InteractReleased:
+		OnInteractReleased();
+		break;
+	default:
+		break;
+	}
+}
+
 void UFineCommonInputControl::OnInputStarted()
 {
-	FP_LOG("Common input started");
+	FineInputReplay::FScopedHandler ReplayScope(this, EFineInputEvent::InputStarted);
+	FP_INPUT_VERBOSE("Common input started");
 }
 
 void UFineCommonInputControl::OnInteractTriggered()
 {
+	FineInputReplay::FScopedHandler ReplayScope(this, EFineInputEvent::InteractTriggered);
 	UAbilitySystemComponent* AbilitySystemComponent = nullptr;
 	if (GetAbilitySystemComponent(AbilitySystemComponent))
 	{
 		AbilitySystemComponent->PressInputID(InteractActionInputID);
-		FP_LOG("Interaction triggered");
+		FP_INPUT_LOG("Interaction triggered");
 	}
 }
 
 void UFineCommonInputControl::OnInteractReleased()
 {
+	FineInputReplay::FScopedHandler ReplayScope(this, EFineInputEvent::InteractReleased);
 	UAbilitySystemComponent* AbilitySystemComponent = nullptr;
 	if (GetAbilitySystemComponent(AbilitySystemComponent))
 	{
 		AbilitySystemComponent->ReleaseInputID(InteractActionInputID);
-		FP_LOG("Interaction released");
+		FP_INPUT_LOG("Interaction released");
 	}
 }
 
 UFineCharacterGameplay* UFineCommonInputControl::GetCharacterGameplay() const
 {
-	const auto PlayerController = CastChecked<APlayerController>(GetOwner());
-	const auto Pawn = PlayerController->GetPawn();
-	if (!IsValid(Pawn))
-	{
-		return nullptr;
-	}
-	return Pawn->FindComponentByClass<UFineCharacterGameplay>();
+	CachePawnComponents();
+	return CachedCharacterGameplay.Get();
 }
 
 bool UFineCommonInputControl::GetAbilitySystemComponent(
 	UAbilitySystemComponent*& OutAbilitySystemComponent) const
 {
-	if (const UFineCharacterGameplay* CharacterGameplay = GetCharacterGameplay())
+	CachePawnComponents();
+	if (CachedCharacterGameplay.IsValid())
 	{
-		const auto Pawn = CharacterGameplay->GetOwner();
-		OutAbilitySystemComponent = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Pawn);
+		OutAbilitySystemComponent = CachedAbilitySystem.Get();
 		return true;
 	}
 	OutAbilitySystemComponent = nullptr;
 	return false;
 }
+
+UCharacterMovementComponent* UFineCommonInputControl::GetCharacterMovement() const
+{
+	CachePawnComponents();
+	return CachedCharacterMovement.Get();
+}
+
+void UFineCommonInputControl::CachePawnComponents() const
+{
+	const auto PlayerController = CastChecked<APlayerController>(GetOwner());
+	const auto Pawn = PlayerController->GetPawn();
+	// Only a pointer comparison while the pawn is the same.
+	if (CachedPawn.Get() == Pawn)
+	{
+		return;
+	}
+	CachedPawn = Pawn;
+	CachedCharacterGameplay = UFineCharacterGameplay::FindCharacterGameplay(Pawn);
+	CachedAbilitySystem = IsValid(Pawn) ? UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Pawn) : nullptr;
+	const auto Character = Cast<ACharacter>(Pawn);
+	CachedCharacterMovement = IsValid(Character) ? Character->GetCharacterMovement() : nullptr;
+}
+
+void UFineCommonInputControl::ClearPawnComponents()
+{
+	CachedPawn = nullptr;
+	CachedCharacterGameplay = nullptr;
+	CachedAbilitySystem = nullptr;
+	CachedCharacterMovement = nullptr;
+}
@@ -0,0 +1,190 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Control/FineCursorEffectComponent.h"
+
+#include "NiagaraComponent.h"
+#include "NiagaraSystem.h"
+#include "GameFramework/Controller.h"
+#include "TimerManager.h"
+
+UFineCursorEffectComponent::UFineCursorEffectComponent(): Super()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UFineCursorEffectComponent::Prewarm(UNiagaraSystem* System)
+{
+	if (!IsValid(System))
+	{
+		return;
+	}
+	Pool.Reserve(PoolSize);
+	StartTimes.Reserve(PoolSize);
+	while (Pool.Num() < PoolSize)
+	{
+		Pool.Add(CreatePooledComponent(System));
+		StartTimes.Add(-UE_BIG_NUMBER);
+	}
+}
+
+UNiagaraComponent* UFineCursorEffectComponent::SpawnEffect(UNiagaraSystem* System, const FVector& Location)
+{
+	if (!IsValid(System))
+	{
+		return nullptr;
+	}
+	const auto Now = GetWorld()->GetTimeSeconds();
+	const auto SinceLastSpawn = Now - LastSpawnTime;
+	LastSpawnTime = Now;
+
+	// Move the effect of the previous click while it still plays.
+	if (Pool.IsValidIndex(LastSlot) && SinceLastSpawn <= RetargetWindow)
+	{
+		const auto Component = Pool[LastSlot].Get();
+		if (IsValid(Component) && Component->IsActive() && Component->GetAsset() == System)
+		{
+			Component->SetWorldLocation(Location);
+			if (Now - StartTimes[LastSlot] >= MinRestartInterval)
+			{
+				StartTimes[LastSlot] = Now;
+				Component->ResetSystem();
+			}
+			ScheduleRelease();
+			return Component;
+		}
+	}
+
+	const auto Slot = AcquireSlot(System);
+	const auto Component = Pool[Slot].Get();
+	Component->SetWorldLocation(Location);
+	Component->Activate(true);
+	StartTimes[Slot] = Now;
+	LastSlot = Slot;
+	ScheduleRelease();
+	return Component;
+}
+
+void UFineCursorEffectComponent::ReleaseAll()
+{
+	for (const auto& Component : Pool)
+	{
+		if (IsValid(Component))
+		{
+			Component->DeactivateImmediate();
+		}
+	}
+	LastSlot = INDEX_NONE;
+	if (const auto World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(ReleaseTimerHandle);
+	}
+}
+
+UFineCursorEffectComponent* UFineCursorEffectComponent::Get(const AController* Controller)
+{
+	return IsValid(Controller) ? Controller->FindComponentByClass<UFineCursorEffectComponent>() : nullptr;
+}
+
+void UFineCursorEffectComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ReleaseAll();
+	for (const auto& Component : Pool)
+	{
+		if (IsValid(Component))
+		{
+			Component->DestroyComponent();
+		}
+	}
+	Pool.Empty();
+	StartTimes.Empty();
+	Super::EndPlay(EndPlayReason);
+}
+
+UNiagaraComponent* UFineCursorEffectComponent::CreatePooledComponent(UNiagaraSystem* System)
+{
+	const auto Component = NewObject<UNiagaraComponent>(GetOwner());
+	Component->SetAutoActivate(false);
+	// Completed effects stay around for reuse.
+	Component->SetAutoDestroy(false);
+	Component->SetUsingAbsoluteLocation(true);
+	Component->SetUsingAbsoluteRotation(true);
+	Component->SetUsingAbsoluteScale(true);
+	Component->SetAsset(System);
+	Component->RegisterComponentWithWorld(GetWorld());
+	return Component;
+}
+
+int32 UFineCursorEffectComponent::AcquireSlot(UNiagaraSystem* System)
+{
+	int32 Slot = INDEX_NONE;
+	for (int32 Index = 0; Index < Pool.Num(); ++Index)
+	{
+		if (!IsValid(Pool[Index]))
+		{
+			Pool[Index] = CreatePooledComponent(System);
+		}
+		if (!Pool[Index]->IsActive())
+		{
+			Slot = Index;
+			break;
+		}
+		if (Slot == INDEX_NONE || StartTimes[Index] < StartTimes[Slot])
+		{
+			Slot = Index;
+		}
+	}
+	if (Slot == INDEX_NONE || (Pool[Slot]->IsActive() && Pool.Num() < PoolSize))
+	{
+		// Only until the pool is full, or when Prewarm wasn't called.
+		Slot = Pool.Add(CreatePooledComponent(System));
+		StartTimes.Add(-UE_BIG_NUMBER);
+		return Slot;
+	}
+	const auto Component = Pool[Slot].Get();
+	if (Component->IsActive())
+	{
+		Component->DeactivateImmediate();
+	}
+	if (Component->GetAsset() != System)
+	{
+		Component->SetAsset(System);
+	}
+	return Slot;
+}
+
+void UFineCursorEffectComponent::ReleaseExpired()
+{
+	const auto Now = GetWorld()->GetTimeSeconds();
+	for (int32 Index = 0; Index < Pool.Num(); ++Index)
+	{
+		const auto Component = Pool[Index].Get();
+		if (IsValid(Component) && Component->IsActive() && Now - StartTimes[Index] >= Lifetime)
+		{
+			Component->DeactivateImmediate();
+		}
+	}
+	ScheduleRelease();
+}
+
+void UFineCursorEffectComponent::ScheduleRelease()
+{
+	// One timer for the effect that expires first.
+	const auto Now = GetWorld()->GetTimeSeconds();
+	auto NextRelease = TNumericLimits<double>::Max();
+	for (int32 Index = 0; Index < Pool.Num(); ++Index)
+	{
+		if (IsValid(Pool[Index]) && Pool[Index]->IsActive())
+		{
+			NextRelease = FMath::Min(NextRelease, StartTimes[Index] + Lifetime);
+		}
+	}
+	auto& TimerManager = GetWorld()->GetTimerManager();
+	if (NextRelease == TNumericLimits<double>::Max())
+	{
+		TimerManager.ClearTimer(ReleaseTimerHandle);
+		return;
+	}
+	TimerManager.SetTimer(ReleaseTimerHandle, this, &UFineCursorEffectComponent::ReleaseExpired,
+	                      FMath::Max(NextRelease - Now, UE_KINDA_SMALL_NUMBER));
+}
@@ -0,0 +1,145 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Control/FineCursorQueryComponent.h"
+
+#include "Diagnostics/FinePlayStats.h"
+#include "GameFramework/PlayerController.h"
+
+UFineCursorQueryComponent::UFineCursorQueryComponent(): Super()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+bool UFineCursorQueryComponent::GetHitResultUnderCursor(FHitResult& OutHit)
+{
+	return GetHitResult(0, TraceChannel, OutHit);
+}
+
+bool UFineCursorQueryComponent::GetHitResultUnderCursorByChannel(ECollisionChannel Channel, FHitResult& OutHit)
+{
+	return GetHitResult(0, Channel, OutHit);
+}
+
+bool UFineCursorQueryComponent::GetHitResultUnderFinger(ETouchIndex::Type FingerIndex, FHitResult& OutHit)
+{
+	return GetHitResult(1 + FingerIndex, TraceChannel, OutHit);
+}
+
+bool UFineCursorQueryComponent::GetHitResultUnderFingerByChannel(ETouchIndex::Type FingerIndex,
+                                                                 ECollisionChannel Channel, FHitResult& OutHit)
+{
+	return GetHitResult(1 + FingerIndex, Channel, OutHit);
+}
+
+bool UFineCursorQueryComponent::GetCursorRay(FVector& OutOrigin, FVector& OutDirection)
+{
+	return GetRay(0, OutOrigin, OutDirection);
+}
+
+bool UFineCursorQueryComponent::GetFingerRay(ETouchIndex::Type FingerIndex, FVector& OutOrigin, FVector& OutDirection)
+{
+	return GetRay(1 + FingerIndex, OutOrigin, OutDirection);
+}
+
+UFineCursorQueryComponent* UFineCursorQueryComponent::Get(const AController* Controller)
+{
+	return IsValid(Controller) ? Controller->FindComponentByClass<UFineCursorQueryComponent>() : nullptr;
+}
+
+bool UFineCursorQueryComponent::GetHitResult(int32 Source, ECollisionChannel Channel, FHitResult& OutHit)
+{
+	auto Cached = CachedHits.FindByPredicate([Source, Channel](const FCachedHit& Entry)
+	{
+		return Entry.Source == Source && Entry.Channel == Channel;
+	});
+	if (Cached == nullptr)
+	{
+		Cached = &CachedHits.AddDefaulted_GetRef();
+		Cached->Source = Source;
+		Cached->Channel = Channel;
+	}
+	else if (Cached->Frame == GFrameCounter)
+	{
+		OutHit = Cached->Hit;
+		return Cached->bHit;
+	}
+
+	Cached->Frame = GFrameCounter;
+	Cached->bHit = false;
+	Cached->Hit.Reset();
+	if (bAsyncTraces)
+	{
+		FVector Origin;
+		FVector Direction;
+		const auto PlayerController = GetPlayerController();
+		if (!IsValid(PlayerController) || !GetRay(Source, Origin, Direction))
+		{
+			// No cursor or the finger was lifted.
+			OutHit = Cached->Hit;
+			return false;
+		}
+		const auto bConsumed = Cached->AsyncTrace.Consume(GetWorld(), Cached->Hit, Cached->bHit);
+		Cached->AsyncTrace.Request(GetWorld(), Origin, Origin + Direction * PlayerController->HitResultTraceDistance,
+		                           Channel, FCollisionQueryParams(SCENE_QUERY_STAT(FineCursorTrace), bTraceComplex));
+		if (bConsumed)
+		{
+			OutHit = Cached->Hit;
+			return Cached->bHit;
+		}
+	}
+
+	FP_SCOPE_CALL(CursorTrace);
+	FVector2D ScreenPosition;
+	const auto PlayerController = GetPlayerController();
+	if (IsValid(PlayerController) && GetScreenPosition(Source, ScreenPosition))
+	{
+		Cached->bHit = PlayerController->GetHitResultAtScreenPosition(ScreenPosition, Channel, bTraceComplex,
+		                                                              Cached->Hit);
+	}
+	OutHit = Cached->Hit;
+	return Cached->bHit;
+}
+
+bool UFineCursorQueryComponent::GetRay(int32 Source, FVector& OutOrigin, FVector& OutDirection)
+{
+	auto Cached = CachedRays.FindByPredicate([Source](const FCachedRay& Entry) { return Entry.Source == Source; });
+	if (Cached == nullptr)
+	{
+		Cached = &CachedRays.AddDefaulted_GetRef();
+		Cached->Source = Source;
+	}
+	if (Cached->Frame != GFrameCounter)
+	{
+		Cached->Frame = GFrameCounter;
+		Cached->bValid = false;
+		FVector2D ScreenPosition;
+		const auto PlayerController = GetPlayerController();
+		if (IsValid(PlayerController) && GetScreenPosition(Source, ScreenPosition))
+		{
+			Cached->bValid = PlayerController->DeprojectScreenPositionToWorld(
+				ScreenPosition.X, ScreenPosition.Y, Cached->Origin, Cached->Direction);
+		}
+	}
+	OutOrigin = Cached->Origin;
+	OutDirection = Cached->Direction;
+	return Cached->bValid;
+}
+
+bool UFineCursorQueryComponent::GetScreenPosition(int32 Source, FVector2D& OutScreenPosition) const
+{
+	const auto PlayerController = GetPlayerController();
+	if (Source == 0)
+	{
+		return PlayerController->GetMousePosition(OutScreenPosition.X, OutScreenPosition.Y);
+	}
+	bool bIsPressed = false;
+	PlayerController->GetInputTouchState(static_cast<ETouchIndex::Type>(Source - 1), OutScreenPosition.X,
+	                                     OutScreenPosition.Y, bIsPressed);
+	return bIsPressed;
+}
+
+APlayerController* UFineCursorQueryComponent::GetPlayerController() const
+{
+	return Cast<APlayerController>(GetOwner());
+}
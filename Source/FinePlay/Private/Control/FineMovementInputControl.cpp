@@ -6,9 +6,16 @@
 #include "AbilitySystemComponent.h"
 #include "EnhancedInputComponent.h"
 #include "FinePlayLog.h"
-#include "NiagaraFunctionLibrary.h"
+#include "Actor/FineCharacterAttributeSet.h"
 #include "Actor/FineCharacterGameplay.h"
-#include "Blueprint/AIBlueprintHelperLibrary.h"
+#include "Control/FineClickToMoveComponent.h"
+#include "Control/FineCursorEffectComponent.h"
+#include "Control/FineCursorQueryComponent.h"
+#include "Diagnostics/FineGameplayTagProfiler.h"
+#include "Diagnostics/FineInputLatency.h"
+#include "Diagnostics/FineInputReplay.h"
+#include "Diagnostics/FinePlayEventRing.h"
+#include "Diagnostics/FinePlayStats.h"
 #include "GameFramework/CharacterMovementComponent.h"
 
 
@@ -96,139 +103,170 @@ void UFineMovementInputControl::SetupInputComponent()
 
 void UFineMovementInputControl::BindCharacterInputEvents()
 {
+	CachePawnComponents();
+	// Move the character with the intents resolved this frame, not the ones from the last frame.
+	if (const auto CharacterMovement = GetCharacterMovement())
+	{
+		CharacterMovement->PrimaryComponentTick.AddPrerequisite(this, PrimaryComponentTick);
+		DependentCharacterMovement = CharacterMovement;
+	}
 	// Get ability system.
 	UAbilitySystemComponent* AbilitySystem;
 	if (!GetAbilitySystemComponent(AbilitySystem))
 	{
 		return;
 	}
+	const auto CharacterGameplay = GetCharacterGameplay();
 	// Bind to running tag change.
-	AbilitySystem->RegisterGameplayTagEvent(FGameplayTag::RequestGameplayTag(TEXT("Actor.State.Running")),
+	AbilitySystem->RegisterGameplayTagEvent(CharacterGameplay->GetRunTag(),
 	                                        EGameplayTagEventType::NewOrRemoved).AddUObject(this,
 		&UFineMovementInputControl::OnAbilitySystemTagChanged);
 	// bind to jumping tag change.
-	AbilitySystem->RegisterGameplayTagEvent(FGameplayTag::RequestGameplayTag(TEXT("Actor.State.Jumping")),
+	AbilitySystem->RegisterGameplayTagEvent(CharacterGameplay->GetJumpTag(),
 	                                        EGameplayTagEventType::NewOrRemoved).AddUObject(this,
 		&UFineMovementInputControl::OnAbilitySystemTagChanged);
+	// Cancel running when stamina is depleted.
+	if (RunActionInputID != INDEX_NONE)
+	{
+		FFineAbilityCancellationRule RunCancellationRule;
+		RunCancellationRule.Attribute = UFineCharacterAttributeSet::GetStaminaAttribute();
+		RunCancellationRule.CancelInputID = RunActionInputID;
+		RunCancellationRuleID = CharacterGameplay->AddAbilityCancellationRule(RunCancellationRule);
+	}
 }
 
 void UFineMovementInputControl::UnbindCharacterInputEvents()
 {
+	if (const auto CharacterMovement = DependentCharacterMovement.Get())
+	{
+		CharacterMovement->PrimaryComponentTick.RemovePrerequisite(this, PrimaryComponentTick);
+	}
+	DependentCharacterMovement = nullptr;
 	// Get ability system.
 	UAbilitySystemComponent* AbilitySystem;
 	if (!GetAbilitySystemComponent(AbilitySystem))
 	{
 		return;
 	}
+	const auto CharacterGameplay = GetCharacterGameplay();
 	// Unbind to running tag change.
-	AbilitySystem->RegisterGameplayTagEvent(FGameplayTag::RequestGameplayTag(TEXT("Actor.State.Running")),
+	AbilitySystem->RegisterGameplayTagEvent(CharacterGameplay->GetRunTag(),
 	                                        EGameplayTagEventType::NewOrRemoved).RemoveAll(this);
 	// Unbind to jumping tag change.
-	AbilitySystem->RegisterGameplayTagEvent(FGameplayTag::RequestGameplayTag(TEXT("Actor.State.Jumping")),
+	AbilitySystem->RegisterGameplayTagEvent(CharacterGameplay->GetJumpTag(),
 	                                        EGameplayTagEventType::NewOrRemoved).RemoveAll(this);
+	if (RunCancellationRuleID != INDEX_NONE)
+	{
+		CharacterGameplay->RemoveAbilityCancellationRule(RunCancellationRuleID);
+		RunCancellationRuleID = INDEX_NONE;
+	}
+	ClearPawnComponents();
 }
 
 void UFineMovementInputControl::BeginPlay()
 {
 	Super::BeginPlay();
-	// Create weak reference to this.
-	const auto WeakThis = TWeakObjectPtr<UFineMovementInputControl>(this);
-	// Set timer movement check
-	auto& TimerManager = GetWorld()->GetTimerManager();
-	TimerManager.SetTimer(MovementTimerHandle,
-	                      [=]()
-	                      {
-		                      if (WeakThis.IsValid())
-		                      {
-			                      const auto This = WeakThis.Get();
-			                      // Get character from controlled pawn.
-			                      const auto PlayerController = CastChecked<APlayerController>(
-				                      This->GetOwner());
-			                      const auto ControlledPawn = PlayerController->GetPawn();
-			                      if (ControlledPawn)
-			                      {
-				                      const auto CharacterMovement = ControlledPawn->
-					                      FindComponentByClass<UCharacterMovementComponent>();
-				                      static const auto MovingTag = FGameplayTag::RequestGameplayTag(
-					                      "Actor.State.Moving");
-				                      UAbilitySystemComponent* AbilitySystem;
-				                      if (!GetAbilitySystemComponent(AbilitySystem))
-				                      {
-					                      return;
-				                      }
-				                      // Check if character is moving.
-				                      if (FMath::IsNearlyEqual(CharacterMovement->Velocity.Size(), 0.0f, 0.1f))
-				                      {
-					                      if (AbilitySystem->HasMatchingGameplayTag(MovingTag))
-					                      {
-						                      AbilitySystem->RemoveLooseGameplayTag(MovingTag);
-						                      FP_VERBOSE("Removing moving tag.");
-					                      }
-				                      }
-				                      else
-				                      {
-					                      if (!AbilitySystem->HasMatchingGameplayTag(MovingTag))
-					                      {
-						                      // Add Actor.State.Moving tag to ability system.
-						                      AbilitySystem->AddLooseGameplayTag(MovingTag);
-						                      FP_VERBOSE("Adding moving tag.");
-					                      }
-				                      }
-			                      }
-		                      }
-	                      }, 0.1f, true);
+	// Resolve movement intents after the controller processed input for the frame.
+	const auto Owner = GetOwner();
+	PrimaryComponentTick.AddPrerequisite(Owner, Owner->PrimaryActorTick);
+	// Create the cursor effect components before the first click. Only local players see them.
+	if (IsValid(FXCursor) && CastChecked<APlayerController>(Owner)->IsLocalController())
+	{
+		GetCursorEffects()->Prewarm(FXCursor);
+	}
 }
 
-void UFineMovementInputControl::EndPlay(const EEndPlayReason::Type EndPlayReason)
+void UFineMovementInputControl::TickComponent(float DeltaTime, ELevelTick TickType,
+                                              FActorComponentTickFunction* ThisTickFunction)
 {
-	// remove movement timer
-	GetWorld()->GetTimerManager().ClearTimer(MovementTimerHandle);
-	Super::EndPlay(EndPlayReason);
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	ResolveMovementIntents(DeltaTime);
+}
+
+void UFineMovementInputControl::ResolveMovementIntents(float DeltaTime)
+{
+	if (PendingMovementIntents == MovementIntent_None)
+	{
+		return;
+	}
+	FP_SCOPE_CALL(MovementInput);
+	const auto Intents = PendingMovementIntents;
+	PendingMovementIntents = MovementIntent_None;
+
+	// The press duration counts even while walking overrides the destination.
+	const auto bPointer = (Intents & (MovementIntent_Touch | MovementIntent_Click)) != 0;
+	if (bPointer)
+	{
+		// We flag that the input is being pressed
+		FollowTime += DeltaTime;
+		bIsTouch = (Intents & MovementIntent_Touch) != 0;
+	}
+
+	if (Intents & MovementIntent_Walk)
+	{
+		// Update cached destination by treating the input value as a direction from the current position.
+		const auto PlayerController = CastChecked<APlayerController>(GetOwner());
+		const auto ControlledPawn = PlayerController->GetPawn();
+		if (!IsValid(ControlledPawn))
+		{
+			return;
+		}
+		constexpr auto WalkInputMagnitude = 100.0f;
+		CachedDestination = ControlledPawn->GetActorLocation() + PendingWalkDirection * WalkInputMagnitude;
+	}
+	else if (bPointer)
+	{
+		// If we hit a surface, cache the location
+		FVector HitLocation;
+		if (GetCursorLocation(HitLocation))
+		{
+			if (bIsTouch && TouchStart == FVector::ZeroVector)
+			{
+				TouchStart = HitLocation;
+			}
+			CachedDestination = HitLocation;
+		}
+	}
+
+	UpdateAddMovementInput();
 }
 
 void UFineMovementInputControl::OnInputStarted()
 {
+	FineInputReplay::FScopedHandler ReplayScope(this, EFineInputEvent::InputStarted);
 	const auto PlayerController = CastChecked<APlayerController>(GetOwner());
 	PlayerController->StopMovement();
+	GetClickToMove()->StopMovement();
 
 	OnMovementStarted.Broadcast();
 }
 
 void UFineMovementInputControl::OnSetDestinationTriggered()
 {
+	FineInputReplay::FScopedHandler ReplayScope(this, EFineInputEvent::SetDestinationTriggered);
 	if (!IsActive())
 	{
 		return;
 	}
-	// We flag that the input is being pressed
-	FollowTime += GetWorld()->GetDeltaSeconds();
-
-	// If we hit a surface, cache the location
-	FVector HitLocation;
-	if (GetCursorLocation(HitLocation))
-	{
-		if (bIsTouch && TouchStart == FVector::ZeroVector)
-		{
-			TouchStart = HitLocation;
-		}
-		CachedDestination = HitLocation;
-	}
-
-	UpdateAddMovementInput();
+	FineInputLatency::BeginChain(CastChecked<APlayerController>(GetOwner())->GetPawn(),
+	                             bIsTouch ? TEXT("Touch") : TEXT("Click"), false);
+	PendingMovementIntents |= bIsTouch ? MovementIntent_Touch : MovementIntent_Click;
 }
 
 void UFineMovementInputControl::OnSetDestinationReleased()
 {
+	FineInputReplay::FScopedHandler ReplayScope(this, EFineInputEvent::SetDestinationReleased);
 	if (!IsActive())
 	{
 		return;
 	}
+	// Apply what was triggered earlier in this frame first.
+	ResolveMovementIntents(GetWorld()->GetDeltaSeconds());
 	// If it was a short press
 	if (FollowTime <= ShortPressThreshold)
 	{
-		const auto PlayerController = CastChecked<APlayerController>(GetOwner());
 		// We move there and spawn some particles
-		UAIBlueprintHelperLibrary::SimpleMoveToLocation(PlayerController, CachedDestination);
+		GetClickToMove()->RequestMoveTo(CachedDestination);
 		SpawnCursorEffect(CachedDestination);
 	}
 
@@ -238,6 +276,7 @@ void UFineMovementInputControl::OnSetDestinationReleased()
 
 void UFineMovementInputControl::OnTouchTriggered()
 {
+	FineInputReplay::FScopedHandler ReplayScope(this, EFineInputEvent::TouchTriggered);
 	if (!IsActive())
 	{
 		return;
@@ -248,33 +287,33 @@ void UFineMovementInputControl::OnTouchTriggered()
 
 void UFineMovementInputControl::OnTouchReleased()
 {
+	FineInputReplay::FScopedHandler ReplayScope(this, EFineInputEvent::TouchReleased);
 	if (!IsActive())
 	{
 		return;
 	}
+	ResolveMovementIntents(GetWorld()->GetDeltaSeconds());
 	bIsTouch = false;
 	OnSetDestinationReleased();
 }
 
 void UFineMovementInputControl::OnWalkTriggered(const FInputActionInstance& InputActionInstance)
 {
+	// Get input value
+	OnWalkInput(InputActionInstance.GetValue().Get<FVector2D>());
+}
+
+void UFineMovementInputControl::OnWalkInput(const FVector2D& InputValue)
+{
+	FineInputReplay::FScopedHandler ReplayScope(this, EFineInputEvent::WalkTriggered,
+	                                            FVector3f(InputValue.X, InputValue.Y, 0.f));
 	if (!IsActive())
 	{
 		return;
 	}
-	// Get input value
-	const FVector2D InputValue = InputActionInstance.GetValue().Get<FVector2D>();
-
-	// Update cached destination by treating the input value as a direction from the current position.
-	const auto PlayerController = CastChecked<APlayerController>(GetOwner());
-	const FVector CurrentLocation = PlayerController->GetPawn()->GetActorLocation();
-	const FVector2D InputDirection = InputValue.GetSafeNormal();
-	const FVector InputDirection3D = FVector(InputDirection, 0.f);
-	constexpr auto WalkInputMagnitude = 100.0f;
-	const FVector NewDestination = CurrentLocation + InputDirection3D * WalkInputMagnitude;
-	CachedDestination = NewDestination;
-
-	UpdateAddMovementInput();
+	FineInputLatency::BeginChain(CastChecked<APlayerController>(GetOwner())->GetPawn(), TEXT("Walk"), false);
+	PendingWalkDirection = FVector(InputValue.GetSafeNormal(), 0.f);
+	PendingMovementIntents |= MovementIntent_Walk;
 }
 
 void UFineMovementInputControl::OnWalkReleased(const FInputActionInstance& InputActionInstance)
@@ -283,6 +322,7 @@ void UFineMovementInputControl::OnWalkReleased(const FInputActionInstance& Input
 
 void UFineMovementInputControl::OnRunKeyTriggered()
 {
+	FineInputReplay::FScopedHandler ReplayScope(this, EFineInputEvent::RunTriggered);
 	if (!IsActive())
 	{
 		return;
@@ -297,12 +337,18 @@ void UFineMovementInputControl::OnRunKeyTriggered()
 		{
 			return;
 		}
+		FineInputLatency::BeginChain(AbilitySystemComponent->GetAvatarActor(), TEXT("Run"), true);
+		// Before pressing, since the ability activates within PressInputID and ends the chain.
+		FineInputLatency::Mark(AbilitySystemComponent->GetAvatarActor(), EFineInputLatencyStage::Applied);
 		AbilitySystemComponent->PressInputID(RunActionInputID);
+		// Still running unless the ability activated, e.g. blocked while exhausted.
+		FineInputLatency::CancelChain(AbilitySystemComponent->GetAvatarActor(), TEXT("Run"));
 	}
 }
 
 void UFineMovementInputControl::OnRunKeyReleased()
 {
+	FineInputReplay::FScopedHandler ReplayScope(this, EFineInputEvent::RunReleased);
 	if (!IsActive())
 	{
 		return;
@@ -317,6 +363,7 @@ void UFineMovementInputControl::OnRunKeyReleased()
 
 void UFineMovementInputControl::OnJumpTriggered()
 {
+	FineInputReplay::FScopedHandler ReplayScope(this, EFineInputEvent::JumpTriggered);
 	if (!IsActive())
 	{
 		return;
@@ -326,12 +373,18 @@ void UFineMovementInputControl::OnJumpTriggered()
 	{
 		return;
 	}
+	FineInputLatency::BeginChain(AbilitySystemComponent->GetAvatarActor(), TEXT("Jump"), true);
+	// Before pressing, since the ability activates within PressInputID and ends the chain.
+	FineInputLatency::Mark(AbilitySystemComponent->GetAvatarActor(), EFineInputLatencyStage::Applied);
 	AbilitySystemComponent->PressInputID(JumpActionInputID);
-	FP_LOG("Jump Triggered");
+	FineInputLatency::CancelChain(AbilitySystemComponent->GetAvatarActor(), TEXT("Jump"));
+	FP_RECORD_EVENT("JumpTriggered", GetFName(), JumpActionInputID);
+	FP_INPUT_VERBOSE("Jump Triggered");
 }
 
 void UFineMovementInputControl::OnJumpReleased()
 {
+	FineInputReplay::FScopedHandler ReplayScope(this, EFineInputEvent::JumpReleased);
 	if (!IsActive())
 	{
 		return;
@@ -342,7 +395,45 @@ void UFineMovementInputControl::OnJumpReleased()
 		return;
 	}
 	AbilitySystemComponent->ReleaseInputID(JumpActionInputID);
-	FP_LOG("Jump released.");
+	FP_RECORD_EVENT("JumpReleased", GetFName(), JumpActionInputID);
+	FP_INPUT_VERBOSE("Jump released.");
+}
+
+void UFineMovementInputControl::ReplayInputEvent(EFineInputEvent Event, const FVector3f& Value)
+{
+	switch (Event)
+	{
+	case EFineInputEvent::SetDestinationTriggered:
+		OnSetDestinationTriggered();
+		break;
+	case EFineInputEvent::SetDestinationReleased:
+		OnSetDestinationReleased();
+		break;
+	case EFineInputEvent::TouchTriggered:
+		OnTouchTriggered();
+		break;
+	case EFineInputEvent::TouchReleased:
+		OnTouchReleased();
+		break;
+	case EFineInputEvent::WalkTriggered:
+		OnWalkInput(FVector2D(Value.X, Value.Y));
+		break;
+	case EFineInputEvent::RunTriggered:
+		OnRunKeyTriggered();
+		break;
+	case EFineInputEvent::RunReleased:
+		OnRunKeyReleased();
+		break;
+	case EFineInputEvent::JumpTriggered:
+		OnJumpTriggered();
+		break;
+	case EFineInputEvent::JumpReleased:
+		OnJumpReleased();
+		break;
+	default:
+		Super::ReplayInputEvent(Event, Value);
+		break;
+	}
 }
 
 void UFineMovementInputControl::SpawnCursorEffect(const FVector& Location)
@@ -353,25 +444,25 @@ void UFineMovementInputControl::SpawnCursorEffect(const FVector& Location)
 	}
 	if (IsValid(FXCursor))
 	{
-		const auto PlayerController = CastChecked<APlayerController>(GetOwner());
-		UNiagaraFunctionLibrary::SpawnSystemAtLocation(PlayerController, FXCursor, Location,
-		                                               FRotator::ZeroRotator,
-		                                               FVector(1.f, 1.f, 1.f), true, true, ENCPoolMethod::None,
-		                                               true);
+		GetCursorEffects()->SpawnEffect(FXCursor, Location);
 	}
 	OnCursorEffectSpawned.Broadcast(Location);
 }
 
 void UFineMovementInputControl::OnAbilitySystemTagChanged(FGameplayTag Tag, int32 NewCount)
 {
-	const auto RunningTag = FGameplayTag::RequestGameplayTag(TEXT("Actor.State.Running"));
-	const auto JumpingTag = FGameplayTag::RequestGameplayTag(TEXT("Actor.State.Jumping"));
+	FineGameplayTagProfiler::FScopedListener ProfilerScope;
+	const auto CharacterGameplay = GetCharacterGameplay();
+	if (!IsValid(CharacterGameplay))
+	{
+		return;
+	}
 	int32 TargetInputID = -1;
-	if (Tag == RunningTag)
+	if (Tag == CharacterGameplay->GetRunTag())
 	{
 		TargetInputID = RunActionInputID;
 	}
-	else if (Tag == JumpingTag)
+	else if (Tag == CharacterGameplay->GetJumpTag())
 	{
 		TargetInputID = JumpActionInputID;
 	}
@@ -404,63 +495,46 @@ void UFineMovementInputControl::OnAbilitySystemTagChanged(FGameplayTag Tag, int3
 
 bool UFineMovementInputControl::IsCharacterRunning()
 {
-	UAbilitySystemComponent* AbilitySystemComponent;
-	if (!GetAbilitySystemComponent(AbilitySystemComponent))
-	{
-		return false;
-	}
 	const auto CharacterGameplay = GetCharacterGameplay();
-	const auto TagRunning = FGameplayTag::RequestGameplayTag(CharacterGameplay->RunGameplayTagName);
-	return AbilitySystemComponent->HasMatchingGameplayTag(TagRunning);
+	return IsValid(CharacterGameplay) && CharacterGameplay->HasState(EFineCharacterState::Running);
 }
 
 bool UFineMovementInputControl::IsCharacterJumping()
 {
-	UAbilitySystemComponent* AbilitySystemComponent;
-	if (!GetAbilitySystemComponent(AbilitySystemComponent))
-	{
-		return false;
-	}
 	const auto CharacterGameplay = GetCharacterGameplay();
-	const auto TagJumping = FGameplayTag::RequestGameplayTag(CharacterGameplay->JumpGameplayTagName);
-	return AbilitySystemComponent->HasMatchingGameplayTag(TagJumping);
+	return IsValid(CharacterGameplay) && CharacterGameplay->HasState(EFineCharacterState::Jumping);
 }
 
-bool UFineMovementInputControl::GetCursorLocation(FVector& OutLocation) const
+bool UFineMovementInputControl::GetCursorLocation(FVector& OutLocation)
 {
+	bool bReplayedHit;
+	if (FineInputReplay::ConsumeCursorLocation(this, bReplayedHit, OutLocation))
+	{
+		return bReplayedHit;
+	}
 	const auto PlayerController = CastChecked<APlayerController>(GetOwner());
 	const auto ControlledPawn = PlayerController->GetPawn();
 	if (!IsValid(ControlledPawn))
 	{
 		return false;
 	}
-	const auto CharacterMovement = ControlledPawn->FindComponentByClass<UCharacterMovementComponent>();
+	const auto CharacterMovement = GetCharacterMovement();
 	bool bHitSuccessful = false;
-	if (CharacterMovement->IsFlying())
-	{
-		// Get screen location of the cursor or finger.
-		FVector2D ScreenLocation;
-		bool IsPressed = false;
-		if (bIsTouch)
-		{
-			PlayerController->GetInputTouchState(ETouchIndex::Touch1, ScreenLocation.X, ScreenLocation.Y, IsPressed);
-		}
-		else
-		{
-			PlayerController->GetMousePosition(ScreenLocation.X, ScreenLocation.Y);
-			IsPressed = true;
-		}
-		if (IsPressed)
+	if (IsValid(CharacterMovement) && CharacterMovement->IsFlying())
+	{
+		// Get the ray through the cursor or finger.
+		FVector RayOrigin;
+		FVector RayDirection;
+		const auto bHasRay = bIsTouch
+			                     ? GetCursorQuery()->GetFingerRay(ETouchIndex::Touch1, RayOrigin, RayDirection)
+			                     : GetCursorQuery()->GetCursorRay(RayOrigin, RayDirection);
+		if (bHasRay)
 		{
 			// Define a x, z plane at the altitude of the character.
 			const FVector PlaneOrigin = ControlledPawn->GetActorLocation();
 			const FVector PlaneNormal = FVector::UpVector;
 			const FPlane Plane(PlaneOrigin, PlaneNormal);
 			// Find intersection of the ray from the camera to the cursor with the plane.
-			FVector RayOrigin;
-			FVector RayDirection;
-			PlayerController->DeprojectScreenPositionToWorld(ScreenLocation.X, ScreenLocation.Y, RayOrigin,
-			                                                 RayDirection);
 			const FVector Intersection = FMath::LinePlaneIntersection(RayOrigin, RayOrigin + RayDirection * 10000.f,
 			                                                          Plane);
 			OutLocation = Intersection;
@@ -469,16 +543,16 @@ bool UFineMovementInputControl::GetCursorLocation(FVector& OutLocation) const
 	}
 	else
 	{
-		// We look for the location in the world where the player has pressed the input
+		// We look for the location in the world where the player has pressed the input.
+		// Traced at most once per frame, however many input events ask.
 		FHitResult Hit;
 		if (bIsTouch)
 		{
-			bHitSuccessful = PlayerController->GetHitResultUnderFinger(ETouchIndex::Touch1,
-			                                                           ECollisionChannel::ECC_Visibility, true, Hit);
+			bHitSuccessful = GetCursorQuery()->GetHitResultUnderFinger(ETouchIndex::Touch1, Hit);
 		}
 		else
 		{
-			bHitSuccessful = PlayerController->GetHitResultUnderCursor(ECollisionChannel::ECC_Visibility, true, Hit);
+			bHitSuccessful = GetCursorQuery()->GetHitResultUnderCursor(Hit);
 		}
 
 		if (bHitSuccessful)
@@ -487,22 +561,69 @@ bool UFineMovementInputControl::GetCursorLocation(FVector& OutLocation) const
 		}
 	}
 
+	FineInputReplay::RecordCursorLocation(this, bHitSuccessful, OutLocation);
 	return bHitSuccessful;
 }
 
+UFineCursorQueryComponent* UFineMovementInputControl::GetCursorQuery()
+{
+	if (!IsValid(CursorQuery))
+	{
+		const auto PlayerController = CastChecked<APlayerController>(GetOwner());
+		CursorQuery = UFineCursorQueryComponent::Get(PlayerController);
+		if (!IsValid(CursorQuery))
+		{
+			CursorQuery = NewObject<UFineCursorQueryComponent>(PlayerController, TEXT("CursorQuery"));
+			CursorQuery->RegisterComponent();
+		}
+	}
+	return CursorQuery;
+}
+
+UFineClickToMoveComponent* UFineMovementInputControl::GetClickToMove()
+{
+	if (!IsValid(ClickToMove))
+	{
+		const auto PlayerController = CastChecked<APlayerController>(GetOwner());
+		ClickToMove = UFineClickToMoveComponent::Get(PlayerController);
+		if (!IsValid(ClickToMove))
+		{
+			ClickToMove = NewObject<UFineClickToMoveComponent>(PlayerController, TEXT("ClickToMove"));
+			ClickToMove->RegisterComponent();
+		}
+	}
+	return ClickToMove;
+}
+
+UFineCursorEffectComponent* UFineMovementInputControl::GetCursorEffects()
+{
+	if (!IsValid(CursorEffects))
+	{
+		const auto PlayerController = CastChecked<APlayerController>(GetOwner());
+		CursorEffects = UFineCursorEffectComponent::Get(PlayerController);
+		if (!IsValid(CursorEffects))
+		{
+			CursorEffects = NewObject<UFineCursorEffectComponent>(PlayerController, TEXT("CursorEffects"));
+			CursorEffects->RegisterComponent();
+		}
+	}
+	return CursorEffects;
+}
+
 void UFineMovementInputControl::UpdateAddMovementInput()
 {
 	if (!IsActive())
 	{
 		return;
 	}
+	const auto PlayerController = CastChecked<APlayerController>(GetOwner());
+	APawn* ControlledPawn = PlayerController->GetPawn();
 	// Move towards mouse pointer or touch
 	if (IsCharacterJumping())
 	{
+		FineInputLatency::CancelChain(ControlledPawn);
 		return;
 	}
-	const auto PlayerController = CastChecked<APlayerController>(GetOwner());
-	APawn* ControlledPawn = PlayerController->GetPawn();
 	FVector Destination;
 	if (bIsTouch)
 	{
@@ -515,8 +636,8 @@ void UFineMovementInputControl::UpdateAddMovementInput()
 	if (ControlledPawn != nullptr)
 	{
 		// Get character gameplay component
-		const auto CharacterGameplay = ControlledPawn->FindComponentByClass<UFineCharacterGameplay>();
-		const auto CharacterMovement = ControlledPawn->FindComponentByClass<UCharacterMovementComponent>();
+		const auto CharacterGameplay = GetCharacterGameplay();
+		const auto CharacterMovement = GetCharacterMovement();
 		FVector WorldDirection = Destination - ControlledPawn->GetActorLocation();
 		if (WorldDirection.IsNearlyZero())
 		{
@@ -530,9 +651,11 @@ void UFineMovementInputControl::UpdateAddMovementInput()
 			if (DistanceFromGround > OffsetDistance)
 			{
 				// Don't add input if the character is jumping.
+				FineInputLatency::CancelChain(ControlledPawn);
 				return;
 			}
 		}
 		ControlledPawn->AddMovementInput(WorldDirection, 1.0, false);
+		FineInputLatency::Mark(ControlledPawn, EFineInputLatencyStage::Applied);
 	}
 }
@@ -5,11 +5,19 @@
 
 #include "AITypes.h"
 #include "GameFramework/Pawn.h"
+#include "Control/FineClickToMoveComponent.h"
+#include "Control/FineCursorEffectComponent.h"
+#include "Control/FineCursorQueryComponent.h"
 #include "Control/FineMovementInputControl.h"
+#include "Diagnostics/FineInputLatency.h"
+#include "Diagnostics/FineInputReplay.h"
 
 AFinePlayerController::AFinePlayerController(): Super()
 {
 	MovementInputControl = CreateDefaultSubobject<UFineMovementInputControl>(TEXT("MovementInputControl"));
+	CursorQuery = CreateDefaultSubobject<UFineCursorQueryComponent>(TEXT("CursorQuery"));
+	ClickToMove = CreateDefaultSubobject<UFineClickToMoveComponent>(TEXT("ClickToMove"));
+	CursorEffects = CreateDefaultSubobject<UFineCursorEffectComponent>(TEXT("CursorEffects"));
 	SetShowMouseCursor(true);
 	DefaultMouseCursor = EMouseCursor::Default;
 }
@@ -24,6 +32,12 @@ void AFinePlayerController::BeginPlay()
 	SetInputMode(InputMode);
 }
 
+void AFinePlayerController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FineInputReplay::StopController(this);
+	Super::EndPlay(EndPlayReason);
+}
+
 void AFinePlayerController::OnPossess(APawn* InPawn)
 {
 	Super::OnPossess(InPawn);
@@ -36,3 +50,15 @@ void AFinePlayerController::OnUnPossess()
 	Super::OnUnPossess();
 }
 
+void AFinePlayerController::ProcessPlayerInput(const float DeltaTime, const bool bGamePaused)
+{
+	// Input handlers run from here on.
+	FineInputLatency::MarkInputEvent();
+	// Replayed input replaces live input.
+	if (FineInputReplay::TickFrame(this, DeltaTime))
+	{
+		return;
+	}
+	Super::ProcessPlayerInput(DeltaTime, bGamePaused);
+}
+
@@ -0,0 +1,489 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Diagnostics/FineAbilityBenchmark.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "AbilitySystemBlueprintLibrary.h"
+#include "AbilitySystemComponent.h"
+#include "FinePlayGameplayTags.h"
+#include "FinePlayLog.h"
+#include "Actor/FineCharacterGameplay.h"
+#include "Actor/FinePaperCharacter.h"
+#include "Containers/Ticker.h"
+#include "Diagnostics/FineBenchmarkAbility.h"
+#include "Dom/JsonObject.h"
+#include "Diagnostics/FineTestWorld.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace FineAbilityBenchmark
+{
+	bool bRecording = false;
+
+	static const TCHAR* PhaseNames[] = {TEXT("CanActivate"), TEXT("Commit"), TEXT("ApplyEffects"), TEXT("End")};
+	static_assert(UE_ARRAY_COUNT(PhaseNames) == static_cast<int32>(EFineAbilityPhase::Count), "Name every phase.");
+
+	static uint64 PhaseCycles[static_cast<int32>(EFineAbilityPhase::Count)];
+	static int32 PhaseCalls[static_cast<int32>(EFineAbilityPhase::Count)];
+
+	void AddPhaseCycles(EFineAbilityPhase Phase, uint64 Cycles)
+	{
+		const auto Index = static_cast<int32>(Phase);
+		PhaseCycles[Index] += Cycles;
+		++PhaseCalls[Index];
+	}
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	/// Low level memory tracker tag of the allocations made by the measured cycles.
+	static const TCHAR* MemoryTagName = TEXT("FinePlay/AbilityBenchmark");
+
+	static int64 GetTrackedBytes()
+	{
+		auto& Tracker = FLowLevelMemTracker::Get();
+		// Collects what the threads tracked since the last frame.
+		Tracker.UpdateStatsPerFrame();
+		return Tracker.GetTagAmountForTracker(ELLMTracker::Default, FName(MemoryTagName), ELLMTagSet::None,
+		                                      UE::LLM::ESizeParams::Default);
+	}
+#endif
+
+	/// The low level memory tracker counts allocations where they're made, on the game thread only.
+	static bool CanMeasureMemory()
+	{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+		return FLowLevelMemTracker::IsEnabled();
+#else
+		return false;
+#endif
+	}
+
+	static void ResetPhases()
+	{
+		FMemory::Memzero(PhaseCycles);
+		FMemory::Memzero(PhaseCalls);
+	}
+
+	struct FSettings
+	{
+		int32 Characters = 50;
+		/// Press and release cycles per character.
+		int32 Cycles = 100;
+		/// Cycles per second over all characters. 0 runs all cycles at once.
+		float Rate = 0.f;
+		TSubclassOf<APawn> CharacterClass;
+		TArray<TSubclassOf<UGameplayAbility>> AbilityClasses;
+		FString OutputPath;
+		FString BaselinePath;
+		/// Allowed regression against the baseline, as a fraction.
+		float Tolerance = 0.1f;
+		/// Reports the bytes that activations keep allocated on the game thread. Needs -llm.
+		bool bMeasureMemory = true;
+
+		void Parse(const FString& Command)
+		{
+			FParse::Value(*Command, TEXT("Characters="), Characters);
+			FParse::Value(*Command, TEXT("Cycles="), Cycles);
+			FParse::Value(*Command, TEXT("Rate="), Rate);
+			FParse::Value(*Command, TEXT("Tolerance="), Tolerance);
+			FParse::Bool(*Command, TEXT("MeasureMemory="), bMeasureMemory);
+			Characters = FMath::Max(Characters, 1);
+			Cycles = FMath::Max(Cycles, 1);
+
+			CharacterClass = AFinePaperCharacter::StaticClass();
+			FString CharacterClassPath;
+			if (FParse::Value(*Command, TEXT("Character="), CharacterClassPath, false))
+			{
+				if (const auto LoadedClass = LoadClass<APawn>(nullptr, *CharacterClassPath))
+				{
+					CharacterClass = LoadedClass;
+				}
+				else
+				{
+					FP_ERROR("Character class not found: %s", *CharacterClassPath);
+				}
+			}
+
+			FString AbilityClassPaths;
+			if (FParse::Value(*Command, TEXT("Abilities="), AbilityClassPaths, false))
+			{
+				TArray<FString> Paths;
+				AbilityClassPaths.ParseIntoArray(Paths, TEXT(","));
+				for (const auto& Path : Paths)
+				{
+					if (const auto LoadedClass = LoadClass<UGameplayAbility>(nullptr, *Path))
+					{
+						AbilityClasses.Add(LoadedClass);
+					}
+					else
+					{
+						FP_ERROR("Ability class not found: %s", *Path);
+					}
+				}
+			}
+			if (AbilityClasses.IsEmpty())
+			{
+				AbilityClasses.Add(UFineBenchmarkAbility::StaticClass());
+			}
+
+			OutputPath = FPaths::ProjectSavedDir() / TEXT("FinePlay") / TEXT("AbilityBenchmark.json");
+			FParse::Value(*Command, TEXT("Output="), OutputPath, false);
+			FParse::Value(*Command, TEXT("Baseline="), BaselinePath, false);
+		}
+	};
+
+	/**
+	 * Spawns characters, grants the abilities and presses and releases their input IDs, then reports and compares
+	 * against a baseline.
+	 */
+	class FRun : public TSharedFromThis<FRun>
+	{
+	public:
+		FRun(UWorld* InWorld, const FSettings& InSettings) : World(InWorld), Settings(InSettings)
+		{
+		}
+
+		bool Setup();
+		void Start();
+		/// Runs every cycle at once regardless of the rate. Returns the number of regressions.
+		int32 RunAll();
+
+	private:
+		void RunCycles(int32 Count);
+		bool Tick(float DeltaTime);
+		int32 Finish();
+		TSharedRef<FJsonObject> MakeReport() const;
+		int32 CompareWithBaseline(const FJsonObject& Report) const;
+
+		TWeakObjectPtr<UWorld> World;
+		FSettings Settings;
+		TArray<TWeakObjectPtr<APawn>> Pawns;
+		TArray<TWeakObjectPtr<UAbilitySystemComponent>> AbilitySystems;
+		TArray<int32> InputIDs;
+
+		int32 NextCycle = 0;
+		int32 TotalCycles = 0;
+		int32 Presses = 0;
+		uint64 MeasuredCycles = 0;
+		int64 TrackedBytes = 0;
+		float PendingCycles = 0.f;
+		double StartTime = 0.0;
+		FTSTicker::FDelegateHandle TickerHandle;
+	};
+
+	/// Input IDs far from the ones games would bind.
+	static constexpr int32 FirstInputID = 10000;
+
+	bool FRun::Setup()
+	{
+		const auto WorldPtr = World.Get();
+		if (!IsValid(WorldPtr))
+		{
+			return false;
+		}
+		for (int32 Index = 0; Index < Settings.AbilityClasses.Num(); ++Index)
+		{
+			InputIDs.Add(FirstInputID + Index);
+		}
+
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		const auto Columns = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(Settings.Characters)));
+		for (int32 Index = 0; Index < Settings.Characters; ++Index)
+		{
+			const FVector Location(Index % Columns * 200.f, Index / Columns * 200.f, 10000.f);
+			const auto Pawn = WorldPtr->SpawnActor<APawn>(Settings.CharacterClass, Location, FRotator::ZeroRotator,
+			                                              SpawnParameters);
+			const auto AbilitySystem = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Pawn);
+			if (!IsValid(AbilitySystem))
+			{
+				FP_ERROR("Benchmark character has no ability system.");
+				if (IsValid(Pawn))
+				{
+					Pawn->Destroy();
+				}
+				continue;
+			}
+			// Grant through FinePlay when the character has the gameplay component, like games do.
+			if (const auto CharacterGameplay = UFineCharacterGameplay::FindCharacterGameplay(Pawn))
+			{
+				TArray<FFineAbilityGrant> Grants;
+				for (int32 AbilityIndex = 0; AbilityIndex < Settings.AbilityClasses.Num(); ++AbilityIndex)
+				{
+					auto& Grant = Grants.AddDefaulted_GetRef();
+					Grant.AbilityClass = Settings.AbilityClasses[AbilityIndex];
+					Grant.InputID = InputIDs[AbilityIndex];
+				}
+				TArray<FGameplayAbilitySpecHandle> Handles;
+				CharacterGameplay->GrantAbilities(Grants, Handles);
+			}
+			else
+			{
+				for (int32 AbilityIndex = 0; AbilityIndex < Settings.AbilityClasses.Num(); ++AbilityIndex)
+				{
+					AbilitySystem->GiveAbility(FGameplayAbilitySpec(Settings.AbilityClasses[AbilityIndex], 1,
+					                                                InputIDs[AbilityIndex], Pawn));
+				}
+				// FinePlay abilities only activate for living characters.
+				AbilitySystem->AddLooseGameplayTag(FinePlayGameplayTags::Actor_State_Alive);
+			}
+			Pawns.Add(Pawn);
+			AbilitySystems.Add(AbilitySystem);
+		}
+		TotalCycles = AbilitySystems.Num() * Settings.Cycles;
+		return TotalCycles > 0;
+	}
+
+	int32 FRun::RunAll()
+	{
+		ResetPhases();
+		StartTime = FPlatformTime::Seconds();
+		RunCycles(TotalCycles);
+		return Finish();
+	}
+
+	void FRun::Start()
+	{
+		if (Settings.Rate <= 0.f)
+		{
+			RunAll();
+			return;
+		}
+		ResetPhases();
+		StartTime = FPlatformTime::Seconds();
+		// The ticker keeps the run alive until it's done.
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda(
+			[Run = AsShared()](float DeltaTime)
+			{
+				return Run->Tick(DeltaTime);
+			}));
+	}
+
+	void FRun::RunCycles(int32 Count)
+	{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+		const auto bMeasureMemory = Settings.bMeasureMemory && CanMeasureMemory();
+		const auto StartBytes = bMeasureMemory ? GetTrackedBytes() : 0;
+		LLM_SCOPE_BYNAME(MemoryTagName);
+#endif
+		bRecording = true;
+		const auto StartCycles = FPlatformTime::Cycles64();
+		for (const auto LastCycle = FMath::Min(NextCycle + Count, TotalCycles); NextCycle < LastCycle; ++NextCycle)
+		{
+			const auto AbilitySystem = AbilitySystems[NextCycle % AbilitySystems.Num()].Get();
+			if (!IsValid(AbilitySystem))
+			{
+				continue;
+			}
+			for (const auto InputID : InputIDs)
+			{
+				AbilitySystem->PressInputID(InputID);
+				AbilitySystem->ReleaseInputID(InputID);
+				++Presses;
+			}
+		}
+		MeasuredCycles += FPlatformTime::Cycles64() - StartCycles;
+		bRecording = false;
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+		if (bMeasureMemory)
+		{
+			TrackedBytes += GetTrackedBytes() - StartBytes;
+		}
+#endif
+	}
+
+	bool FRun::Tick(float DeltaTime)
+	{
+		if (!World.IsValid())
+		{
+			FP_ERROR("World went away during the ability benchmark.");
+			return false;
+		}
+		PendingCycles += Settings.Rate * DeltaTime;
+		const auto Count = FMath::FloorToInt(PendingCycles);
+		PendingCycles -= Count;
+		RunCycles(Count);
+		if (NextCycle < TotalCycles)
+		{
+			return true;
+		}
+		Finish();
+		return false;
+	}
+
+	int32 FRun::Finish()
+	{
+		const auto Report = MakeReport();
+		FString Json;
+		const auto Writer = TJsonWriterFactory<>::Create(&Json);
+		FJsonSerializer::Serialize(Report, Writer);
+		if (FFileHelper::SaveStringToFile(Json, *Settings.OutputPath))
+		{
+			FP_DISPLAY("Ability benchmark written to %s", *Settings.OutputPath);
+		}
+		FP_DISPLAY("Ability benchmark: %s", *Json);
+		const auto Regressions = Settings.BaselinePath.IsEmpty() ? 0 : CompareWithBaseline(*Report);
+		for (const auto& Pawn : Pawns)
+		{
+			if (Pawn.IsValid())
+			{
+				Pawn->Destroy();
+			}
+		}
+		Pawns.Empty();
+		AbilitySystems.Empty();
+		return Regressions;
+	}
+
+	TSharedRef<FJsonObject> FRun::MakeReport() const
+	{
+		// Abilities that actually activated, or presses if none of them are FinePlay abilities.
+		const auto Commits = PhaseCalls[static_cast<int32>(EFineAbilityPhase::Commit)];
+		const auto Activations = FMath::Max(Commits > 0 ? Commits : Presses, 1);
+		const auto Seconds = FPlatformTime::ToSeconds64(MeasuredCycles);
+
+		const auto Report = MakeShared<FJsonObject>();
+		Report->SetNumberField(TEXT("Characters"), AbilitySystems.Num());
+		Report->SetNumberField(TEXT("Abilities"), InputIDs.Num());
+		Report->SetNumberField(TEXT("Presses"), Presses);
+		Report->SetNumberField(TEXT("Activations"), Commits);
+		Report->SetNumberField(TEXT("MeasuredSeconds"), Seconds);
+		Report->SetNumberField(TEXT("WallSeconds"), FPlatformTime::Seconds() - StartTime);
+		Report->SetNumberField(TEXT("ActivationsPerSecond"), Seconds > 0.0 ? Activations / Seconds : 0.0);
+		Report->SetNumberField(TEXT("MicrosecondsPerActivation"), Seconds * 1000000.0 / Activations);
+		if (Settings.bMeasureMemory && CanMeasureMemory())
+		{
+			Report->SetNumberField(TEXT("AllocatedBytesPerActivation"),
+			                       static_cast<double>(TrackedBytes) / Activations);
+		}
+		const auto Phases = MakeShared<FJsonObject>();
+		for (int32 Index = 0; Index < static_cast<int32>(EFineAbilityPhase::Count); ++Index)
+		{
+			const auto Phase = MakeShared<FJsonObject>();
+			Phase->SetNumberField(TEXT("Calls"), PhaseCalls[Index]);
+			Phase->SetNumberField(TEXT("MicrosecondsPerActivation"),
+			                      FPlatformTime::ToSeconds64(PhaseCycles[Index]) * 1000000.0 / Activations);
+			Phases->SetObjectField(PhaseNames[Index], Phase);
+		}
+		Report->SetObjectField(TEXT("Phases"), Phases);
+		return Report;
+	}
+
+	int32 FRun::CompareWithBaseline(const FJsonObject& Report) const
+	{
+		FString Json;
+		TSharedPtr<FJsonObject> Baseline;
+		if (!FFileHelper::LoadFileToString(Json, *Settings.BaselinePath) ||
+			!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Baseline) || !Baseline.IsValid())
+		{
+			FP_ERROR("Failed to read ability benchmark baseline: %s", *Settings.BaselinePath);
+			return 1;
+		}
+		int32 Regressions = 0;
+		// Higher is worse unless stated otherwise.
+		const auto Compare = [this, &Regressions](const FString& Name, const double Value, const double BaselineValue,
+		                                          const bool bHigherIsBetter)
+		{
+			if (BaselineValue <= 0.0)
+			{
+				return;
+			}
+			const auto Change = (Value - BaselineValue) / BaselineValue;
+			const auto bRegressed = bHigherIsBetter ? Change < -Settings.Tolerance : Change > Settings.Tolerance;
+			if (bRegressed)
+			{
+				++Regressions;
+				FP_ERROR("%s regressed: %.3f, baseline %.3f (%+.1f%%)", *Name, Value, BaselineValue, Change * 100.0);
+			}
+			else
+			{
+				FP_DISPLAY("%s: %.3f, baseline %.3f (%+.1f%%)", *Name, Value, BaselineValue, Change * 100.0);
+			}
+		};
+		Compare(TEXT("ActivationsPerSecond"), Report.GetNumberField(TEXT("ActivationsPerSecond")),
+		        Baseline->GetNumberField(TEXT("ActivationsPerSecond")), true);
+		const TSharedPtr<FJsonObject>* BaselinePhases;
+		if (Baseline->TryGetObjectField(TEXT("Phases"), BaselinePhases))
+		{
+			const auto Phases = Report.GetObjectField(TEXT("Phases"));
+			for (const auto PhaseName : PhaseNames)
+			{
+				const TSharedPtr<FJsonObject>* BaselinePhase;
+				if ((*BaselinePhases)->TryGetObjectField(PhaseName, BaselinePhase))
+				{
+					Compare(PhaseName, Phases->GetObjectField(PhaseName)->GetNumberField(TEXT("MicrosecondsPerActivation")),
+					        (*BaselinePhase)->GetNumberField(TEXT("MicrosecondsPerActivation")), false);
+				}
+			}
+		}
+		if (Regressions > 0)
+		{
+			FP_ERROR("Ability benchmark: %d regression(s) against %s", Regressions, *Settings.BaselinePath);
+		}
+		else
+		{
+			FP_DISPLAY("Ability benchmark: no regressions against %s", *Settings.BaselinePath);
+		}
+		return Regressions;
+	}
+
+	static void RunBenchmark(const TArray<FString>& Args, UWorld* World)
+	{
+		if (!IsValid(World) || !World->IsGameWorld())
+		{
+			FP_ERROR("The ability benchmark needs a game world.");
+			return;
+		}
+		FSettings Settings;
+		Settings.Parse(FString::Join(Args, TEXT(" ")));
+		const auto Run = MakeShared<FRun>(World, Settings);
+		if (!Run->Setup())
+		{
+			FP_ERROR("Failed to set up the ability benchmark.");
+			return;
+		}
+		Run->Start();
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchmarkCommand(
+		TEXT("FinePlay.Bench.Abilities"),
+		TEXT("Measures ability activation throughput. Arguments: Characters=50 Cycles=100 Rate=0 Character=<class path> ")
+		TEXT("Abilities=<class path>,... Output=<json path> Baseline=<json path> Tolerance=0.1 MeasureMemory=true"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunBenchmark));
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFineAbilityBenchmarkTest, "FinePlay.Performance.AbilityActivation",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext |
+                                 EAutomationTestFlags::PerfFilter)
+
+/// Runs the benchmark in a world of its own, also headless, e.g. with
+/// -ExecCmds="Automation RunTests FinePlay.Performance". Settings come from -FinePlayBench="Characters=50 ...".
+bool FFineAbilityBenchmarkTest::RunTest(const FString& Parameters)
+{
+	using namespace FineAbilityBenchmark;
+
+	const FFineTestWorld World;
+	FString Command;
+	FParse::Value(FCommandLine::Get(), TEXT("FinePlayBench="), Command, false);
+	FSettings Settings;
+	Settings.Parse(Command);
+	FRun Run(World.Get(), Settings);
+	if (!Run.Setup())
+	{
+		AddError(TEXT("Failed to set up the ability benchmark."));
+		return false;
+	}
+	const auto Regressions = Run.RunAll();
+	TestEqual(TEXT("Regressions against the baseline"), Regressions, 0);
+	return Regressions == 0;
+}
+
+#endif
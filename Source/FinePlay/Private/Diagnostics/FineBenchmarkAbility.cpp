@@ -0,0 +1,12 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Diagnostics/FineBenchmarkAbility.h"
+
+#include "GameplayEffect.h"
+
+UFineBenchmarkAbility::UFineBenchmarkAbility(): Super()
+{
+	InstancingPolicy = EGameplayAbilityInstancingPolicy::InstancedPerActor;
+	EffectClasses.Add(UGameplayEffect::StaticClass());
+}
@@ -0,0 +1,27 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Actor/FineBaseAbility.h"
+#include "FineBenchmarkAbility.generated.h"
+
+/**
+ * Applies the given effects while active. Used by the ability benchmark when no ability classes are given.
+ *
+ * UHT can't compile classes out, so this stays in every build, but only the benchmark grants it.
+ */
+UCLASS(NotBlueprintable, HideDropdown, Transient)
+class UFineBenchmarkAbility : public UFineBaseAbility
+{
+	GENERATED_BODY()
+
+public:
+	UFineBenchmarkAbility();
+
+	UPROPERTY(EditDefaultsOnly, Category = "FineBenchmarkAbility")
+	TArray<TSubclassOf<UGameplayEffect>> EffectClasses;
+
+protected:
+	virtual TArray<TSubclassOf<UGameplayEffect>> GetEffectClasses() override { return EffectClasses; }
+};
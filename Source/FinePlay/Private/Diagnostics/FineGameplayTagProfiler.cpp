@@ -0,0 +1,220 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Diagnostics/FineGameplayTagProfiler.h"
+
+#include "AbilitySystemComponent.h"
+#include "FinePlayLog.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/ObjectKey.h"
+
+namespace FineGameplayTagProfiler
+{
+	bool bEnabled = false;
+
+	/// Traffic of one tag on one character.
+	struct FTagTraffic
+	{
+		FString OwnerName;
+		FGameplayTag Tag;
+		uint32 Adds = 0;
+		uint32 Removes = 0;
+		uint32 ListenerCalls = 0;
+		uint64 DispatchCycles = 0;
+		uint64 ListenerCycles = 0;
+
+		uint32 GetChanges() const { return Adds + Removes; }
+	};
+
+	struct FTrafficKey
+	{
+		FObjectKey Owner;
+		FGameplayTag Tag;
+
+		bool operator==(const FTrafficKey& Other) const { return Owner == Other.Owner && Tag == Other.Tag; }
+
+		friend uint32 GetTypeHash(const FTrafficKey& Key)
+		{
+			return HashCombine(GetTypeHash(Key.Owner), GetTypeHash(Key.Tag));
+		}
+	};
+
+	TArray<FTagTraffic> Traffic;
+	TMap<FTrafficKey, int32> TrafficIndices;
+	/// Changes being dispatched, innermost last. Listeners may add or remove tags themselves.
+	TArray<int32, TInlineAllocator<8>> DispatchStack;
+	double StartTime = 0.0;
+
+	void Reset()
+	{
+		Traffic.Reset();
+		TrafficIndices.Reset();
+		StartTime = FPlatformTime::Seconds();
+	}
+
+	double GetElapsedSeconds()
+	{
+		return FMath::Max(FPlatformTime::Seconds() - StartTime, UE_SMALL_NUMBER);
+	}
+
+	int32 FindOrAddTraffic(const UAbilitySystemComponent* AbilitySystem, const FGameplayTag& Tag)
+	{
+		const auto Owner = AbilitySystem->GetOwnerActor();
+		const FTrafficKey Key{FObjectKey(Owner), Tag};
+		if (const auto Index = TrafficIndices.Find(Key))
+		{
+			return *Index;
+		}
+		const auto Index = Traffic.AddDefaulted();
+		Traffic[Index].OwnerName = GetNameSafe(Owner);
+		Traffic[Index].Tag = Tag;
+		TrafficIndices.Add(Key, Index);
+		return Index;
+	}
+
+	template <typename FChange>
+	void Dispatch(UAbilitySystemComponent* AbilitySystem, const FGameplayTag& Tag, const bool bAdd, FChange&& Change)
+	{
+		if (!bEnabled || !IsInGameThread())
+		{
+			Change();
+			return;
+		}
+		const auto Index = FindOrAddTraffic(AbilitySystem, Tag);
+		(bAdd ? Traffic[Index].Adds : Traffic[Index].Removes)++;
+		DispatchStack.Push(Index);
+		const auto StartCycles = FPlatformTime::Cycles64();
+		Change();
+		// Indices stay valid when nested changes add entries.
+		Traffic[Index].DispatchCycles += FPlatformTime::Cycles64() - StartCycles;
+		DispatchStack.Pop(EAllowShrinking::No);
+	}
+
+	void AddLooseTag(UAbilitySystemComponent* AbilitySystem, const FGameplayTag& Tag)
+	{
+		Dispatch(AbilitySystem, Tag, true, [&] { AbilitySystem->AddLooseGameplayTag(Tag); });
+	}
+
+	void RemoveLooseTag(UAbilitySystemComponent* AbilitySystem, const FGameplayTag& Tag)
+	{
+		Dispatch(AbilitySystem, Tag, false, [&] { AbilitySystem->RemoveLooseGameplayTag(Tag); });
+	}
+
+	void AddListenerCycles(uint64 Cycles)
+	{
+		// Changes made without the profiler, e.g. by gameplay effects, have nothing to attribute to.
+		if (DispatchStack.IsEmpty() || !IsInGameThread())
+		{
+			return;
+		}
+		auto& Entry = Traffic[DispatchStack.Last()];
+		Entry.ListenerCalls++;
+		Entry.ListenerCycles += Cycles;
+	}
+
+	/// Busiest first.
+	TArray<const FTagTraffic*> GetSortedTraffic()
+	{
+		TArray<const FTagTraffic*> Sorted;
+		Sorted.Reserve(Traffic.Num());
+		for (const auto& Entry : Traffic)
+		{
+			Sorted.Add(&Entry);
+		}
+		Sorted.Sort([](const FTagTraffic& A, const FTagTraffic& B)
+		{
+			return A.GetChanges() != B.GetChanges()
+				       ? A.GetChanges() > B.GetChanges()
+				       : A.DispatchCycles > B.DispatchCycles;
+		});
+		return Sorted;
+	}
+
+	void Dump(int32 Count)
+	{
+		const auto Seconds = GetElapsedSeconds();
+		const auto Sorted = GetSortedTraffic();
+		const auto Num = FMath::Min(Count, Sorted.Num());
+		FP_DISPLAY("Gameplay tag traffic over %.1f s, %d of %d character/tag pairs:", Seconds, Num, Sorted.Num());
+		FP_DISPLAY("%-24s %-40s %8s %8s %8s %10s %10s", TEXT("Owner"), TEXT("Tag"), TEXT("Add/s"), TEXT("Rem/s"),
+		           TEXT("Fan-out"), TEXT("Disp ms/s"), TEXT("Lstn ms/s"));
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			const auto& Entry = *Sorted[Index];
+			FP_DISPLAY("%-24s %-40s %8.2f %8.2f %8.2f %10.3f %10.3f", *Entry.OwnerName, *Entry.Tag.ToString(),
+			           Entry.Adds / Seconds, Entry.Removes / Seconds,
+			           Entry.GetChanges() > 0 ? static_cast<double>(Entry.ListenerCalls) / Entry.GetChanges() : 0.0,
+			           FPlatformTime::ToMilliseconds64(Entry.DispatchCycles) / Seconds,
+			           FPlatformTime::ToMilliseconds64(Entry.ListenerCycles) / Seconds);
+		}
+	}
+
+	void DumpCsv(const FString& InPath)
+	{
+		const auto Seconds = GetElapsedSeconds();
+		const auto Path = InPath.IsEmpty()
+			                  ? FPaths::ProfilingDir() / TEXT("FinePlay") / FString::Printf(
+				                  TEXT("TagTraffic-%s.csv"), *FDateTime::Now().ToString())
+			                  : InPath;
+		FString Csv = TEXT(
+			"Owner,Tag,Adds,Removes,ListenerCalls,DispatchMs,ListenerMs,Seconds,AddsPerSecond,RemovesPerSecond,"
+			"FanOut,DispatchMsPerSecond,ListenerMsPerSecond\n");
+		for (const auto Entry : GetSortedTraffic())
+		{
+			const auto DispatchMs = FPlatformTime::ToMilliseconds64(Entry->DispatchCycles);
+			const auto ListenerMs = FPlatformTime::ToMilliseconds64(Entry->ListenerCycles);
+			Csv += FString::Printf(TEXT("%s,%s,%u,%u,%u,%.4f,%.4f,%.3f,%.4f,%.4f,%.4f,%.4f,%.4f\n"),
+			                       *Entry->OwnerName, *Entry->Tag.ToString(), Entry->Adds, Entry->Removes,
+			                       Entry->ListenerCalls, DispatchMs, ListenerMs, Seconds, Entry->Adds / Seconds,
+			                       Entry->Removes / Seconds,
+			                       Entry->GetChanges() > 0
+				                       ? static_cast<double>(Entry->ListenerCalls) / Entry->GetChanges()
+				                       : 0.0, DispatchMs / Seconds, ListenerMs / Seconds);
+		}
+		if (FFileHelper::SaveStringToFile(Csv, *Path))
+		{
+			FP_DISPLAY("Wrote gameplay tag traffic to %s", *Path);
+		}
+		else
+		{
+			FP_ERROR("Failed to write gameplay tag traffic to %s", *Path);
+		}
+	}
+
+	static FAutoConsoleVariableRef CVarEnabled(
+		TEXT("FinePlay.TagProfiler.Enable"), bEnabled,
+		TEXT("Records loose gameplay tag adds, removes, listener fan-out and dispatch time per character. "
+			"Enabling starts a new recording."),
+		FConsoleVariableDelegate::CreateLambda([](IConsoleVariable*)
+		{
+			if (bEnabled)
+			{
+				Reset();
+			}
+		}));
+
+	static FAutoConsoleCommand DumpCommand(
+		TEXT("FinePlay.TagProfiler.Dump"),
+		TEXT("Writes recorded gameplay tag traffic to the log, busiest first. Optional argument: number of rows."),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			Dump(Args.IsEmpty() ? 32 : FCString::Atoi(*Args[0]));
+		}));
+
+	static FAutoConsoleCommand DumpCsvCommand(
+		TEXT("FinePlay.TagProfiler.DumpCsv"),
+		TEXT("Writes recorded gameplay tag traffic as CSV. Optional argument: file path, defaults to the profiling "
+			"directory."),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			DumpCsv(Args.IsEmpty() ? FString() : Args[0]);
+		}));
+
+	static FAutoConsoleCommand ResetCommand(
+		TEXT("FinePlay.TagProfiler.Reset"),
+		TEXT("Clears recorded gameplay tag traffic."),
+		FConsoleCommandDelegate::CreateStatic(&Reset));
+}
@@ -0,0 +1,429 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Diagnostics/FineInputLatency.h"
+
+#include "FinePlayLog.h"
+#include "Diagnostics/FinePlayStats.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "UObject/ObjectKey.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+#include "AbilitySystemBlueprintLibrary.h"
+#include "AbilitySystemComponent.h"
+#include "FinePlayGameplayTags.h"
+#include "Control/FineMovementInputControl.h"
+#include "Control/FinePlayerController.h"
+#include "Diagnostics/FineBenchmarkAbility.h"
+#include "Diagnostics/FineInputReplay.h"
+#include "Diagnostics/FineTestWorld.h"
+#include "Misc/AutomationTest.h"
+#endif
+
+CSV_DEFINE_CATEGORY(FinePlayInputLatency, true);
+
+static TAutoConsoleVariable<float> CVarFinePlayInputLatencyTimeout(
+	TEXT("FinePlay.InputLatency.Timeout"), 1.f,
+	TEXT("Seconds after which an input latency chain that didn't end is dropped."));
+
+namespace FineInputLatency
+{
+	bool bEnabled = false;
+
+	const TCHAR* GetStageName(const EFineInputLatencyStage Stage)
+	{
+		switch (Stage)
+		{
+		case EFineInputLatencyStage::Event:
+			return TEXT("Event");
+		case EFineInputLatencyStage::Handler:
+			return TEXT("Handler");
+		case EFineInputLatencyStage::Applied:
+			return TEXT("Applied");
+		case EFineInputLatencyStage::Activated:
+			return TEXT("Activated");
+		case EFineInputLatencyStage::Motion:
+			return TEXT("Motion");
+		default:
+			return TEXT("Unknown");
+		}
+	}
+
+	/// Input of one pawn on its way to a response.
+	struct FChain
+	{
+		FName Action;
+		bool bEndsAtActivation = false;
+		/// Cycles at each stage, 0 if not reached.
+		uint64 StageCycles[static_cast<int32>(EFineInputLatencyStage::Num)] = {};
+
+		FORCEINLINE uint64 GetStartCycles() const { return StageCycles[0]; }
+	};
+
+	struct FActionLatency
+	{
+		FLatencyHistogram Stages[static_cast<int32>(EFineInputLatencyStage::Num)];
+	};
+
+	uint64 InputEventCycles = 0;
+	uint64 InputEventFrame = 0;
+	TMap<FObjectKey, FChain> Chains;
+	TMap<FName, FActionLatency> Actions;
+	uint32 TimedOutChains = 0;
+
+	void FLatencyHistogram::Add(const double Ms)
+	{
+		int32 Bin = 0;
+		while (Bin < NumBins - 1 && Ms > BinBounds[Bin])
+		{
+			++Bin;
+		}
+		Bins[Bin]++;
+		MinMs = Count == 0 ? Ms : FMath::Min(MinMs, Ms);
+		MaxMs = Count == 0 ? Ms : FMath::Max(MaxMs, Ms);
+		SumMs += Ms;
+		Count++;
+	}
+
+	double FLatencyHistogram::GetPercentile(const double Percentile) const
+	{
+		const auto Target = FMath::CeilToInt64(Count * Percentile / 100.0);
+		uint64 Seen = 0;
+		for (int32 Bin = 0; Bin < NumBins - 1; ++Bin)
+		{
+			Seen += Bins[Bin];
+			if (Seen >= static_cast<uint64>(Target))
+			{
+				return FMath::Min(BinBounds[Bin], MaxMs);
+			}
+		}
+		return MaxMs;
+	}
+
+	void SetStat(const EFineInputLatencyStage Stage, const double Ms)
+	{
+		switch (Stage)
+		{
+		case EFineInputLatencyStage::Handler:
+			SET_FLOAT_STAT(STAT_FinePlay_InputToHandler, Ms);
+			break;
+		case EFineInputLatencyStage::Applied:
+			SET_FLOAT_STAT(STAT_FinePlay_InputToApplied, Ms);
+			break;
+		case EFineInputLatencyStage::Activated:
+			SET_FLOAT_STAT(STAT_FinePlay_InputToActivation, Ms);
+			CSV_CUSTOM_STAT(FinePlayInputLatency, InputToActivationMs, Ms, ECsvCustomStatOp::Set);
+			break;
+		case EFineInputLatencyStage::Motion:
+			SET_FLOAT_STAT(STAT_FinePlay_InputToMotion, Ms);
+			CSV_CUSTOM_STAT(FinePlayInputLatency, InputToMotionMs, Ms, ECsvCustomStatOp::Set);
+			break;
+		default:
+			break;
+		}
+	}
+
+	void MarkInputEvent()
+	{
+		if (!bEnabled)
+		{
+			return;
+		}
+		InputEventCycles = FPlatformTime::Cycles64();
+		InputEventFrame = GFrameCounter;
+	}
+
+	bool HasTimedOut(const FChain& Chain, const uint64 Now)
+	{
+		return FPlatformTime::ToSeconds64(Now - Chain.GetStartCycles()) >=
+			CVarFinePlayInputLatencyTimeout.GetValueOnGameThread();
+	}
+
+	void BeginChain(const AActor* Pawn, const FName Action, const bool bEndsAtActivation)
+	{
+		if (!bEnabled || !IsValid(Pawn) || !IsInGameThread())
+		{
+			return;
+		}
+		const auto Now = FPlatformTime::Cycles64();
+		const FObjectKey Key(Pawn);
+		if (const auto Running = Chains.Find(Key))
+		{
+			if (HasTimedOut(*Running, Now))
+			{
+				TimedOutChains++;
+			}
+			else if (Running->Action == Action)
+			{
+				// Handlers are called every frame while the input is held.
+				return;
+			}
+			// The newer input is what the player waits for.
+			Chains.Remove(Key);
+		}
+		// Input while already moving has nothing to respond to.
+		if (!bEndsAtActivation && !Pawn->GetVelocity().IsNearlyZero())
+		{
+			return;
+		}
+		auto& Chain = Chains.Add(Key);
+		Chain.Action = Action;
+		Chain.bEndsAtActivation = bEndsAtActivation;
+		// Handlers called outside of input processing, e.g. by a replay, start at the handler.
+		Chain.StageCycles[static_cast<int32>(EFineInputLatencyStage::Event)] =
+			InputEventFrame == GFrameCounter ? InputEventCycles : Now;
+		Chain.StageCycles[static_cast<int32>(EFineInputLatencyStage::Handler)] = Now;
+		const auto Ms = FPlatformTime::ToMilliseconds64(Now - Chain.GetStartCycles());
+		Actions.FindOrAdd(Action).Stages[static_cast<int32>(EFineInputLatencyStage::Handler)].Add(Ms);
+		SetStat(EFineInputLatencyStage::Handler, Ms);
+	}
+
+	void Mark(const AActor* Pawn, const EFineInputLatencyStage Stage)
+	{
+		if (!bEnabled || Chains.IsEmpty() || !IsInGameThread())
+		{
+			return;
+		}
+		const FObjectKey Key(Pawn);
+		const auto Chain = Chains.Find(Key);
+		if (!Chain || Chain->StageCycles[static_cast<int32>(Stage)] != 0)
+		{
+			return;
+		}
+		const auto Now = FPlatformTime::Cycles64();
+		// Whatever reaches the stage now wasn't caused by that input.
+		if (HasTimedOut(*Chain, Now))
+		{
+			TimedOutChains++;
+			Chains.Remove(Key);
+			return;
+		}
+		Chain->StageCycles[static_cast<int32>(Stage)] = Now;
+		const auto Ms = FPlatformTime::ToMilliseconds64(Now - Chain->GetStartCycles());
+		Actions.FindOrAdd(Chain->Action).Stages[static_cast<int32>(Stage)].Add(Ms);
+		SetStat(Stage, Ms);
+		const auto EndStage = Chain->bEndsAtActivation
+			                      ? EFineInputLatencyStage::Activated
+			                      : EFineInputLatencyStage::Motion;
+		if (Stage == EndStage)
+		{
+			FP_INPUT_VERBOSE("%s input latency of %s: %.2f ms", *Chain->Action.ToString(), *GetNameSafe(Pawn), Ms);
+			Chains.Remove(Key);
+		}
+	}
+
+	void CancelChain(const AActor* Pawn, const FName Action)
+	{
+		if (!bEnabled || Chains.IsEmpty() || !IsInGameThread())
+		{
+			return;
+		}
+		const FObjectKey Key(Pawn);
+		const auto Chain = Chains.Find(Key);
+		if (Chain && (Action.IsNone() || Chain->Action == Action))
+		{
+			Chains.Remove(Key);
+		}
+	}
+
+	const FLatencyHistogram* FindHistogram(const FName Action, const EFineInputLatencyStage Stage)
+	{
+		const auto Latency = Actions.Find(Action);
+		return Latency && Latency->Stages[static_cast<int32>(Stage)].Count > 0
+			       ? &Latency->Stages[static_cast<int32>(Stage)]
+			       : nullptr;
+	}
+
+	uint32 GetTimedOutChains()
+	{
+		return TimedOutChains;
+	}
+
+	void Reset()
+	{
+		Chains.Reset();
+		Actions.Reset();
+		TimedOutChains = 0;
+		InputEventFrame = 0;
+	}
+
+	template <typename FVisitor>
+	void ForEachHistogram(FVisitor&& Visitor)
+	{
+		for (const auto& Pair : Actions)
+		{
+			for (int32 Stage = static_cast<int32>(EFineInputLatencyStage::Handler);
+			     Stage < static_cast<int32>(EFineInputLatencyStage::Num); ++Stage)
+			{
+				if (Pair.Value.Stages[Stage].Count > 0)
+				{
+					Visitor(Pair.Key, static_cast<EFineInputLatencyStage>(Stage), Pair.Value.Stages[Stage]);
+				}
+			}
+		}
+	}
+
+	void Dump()
+	{
+		FP_DISPLAY("Input latency in ms since the input event, %u chains timed out:", TimedOutChains);
+		FP_DISPLAY("%-16s %-10s %8s %8s %8s %8s %8s %8s %8s", TEXT("Action"), TEXT("Stage"), TEXT("Count"),
+		           TEXT("Min"), TEXT("Mean"), TEXT("P50"), TEXT("P90"), TEXT("P99"), TEXT("Max"));
+		ForEachHistogram([](const FName Action, const EFineInputLatencyStage Stage, const FLatencyHistogram& Histogram)
+		{
+			FP_DISPLAY("%-16s %-10s %8u %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f", *Action.ToString(), GetStageName(Stage),
+			           Histogram.Count, Histogram.MinMs, Histogram.GetMean(), Histogram.GetPercentile(50.0),
+			           Histogram.GetPercentile(90.0), Histogram.GetPercentile(99.0), Histogram.MaxMs);
+		});
+	}
+
+	void DumpCsv(const FString& InPath)
+	{
+		const auto Path = InPath.IsEmpty()
+			                  ? FPaths::ProfilingDir() / TEXT("FinePlay") / FString::Printf(
+				                  TEXT("InputLatency-%s.csv"), *FDateTime::Now().ToString())
+			                  : InPath;
+		FString Csv = TEXT("Action,Stage,Count,MinMs,MeanMs,P50Ms,P90Ms,P99Ms,MaxMs");
+		for (const auto Bound : FLatencyHistogram::BinBounds)
+		{
+			Csv += FString::Printf(TEXT(",Le%.1fMs"), Bound);
+		}
+		Csv += TEXT(",Above\n");
+		ForEachHistogram([&Csv](const FName Action, const EFineInputLatencyStage Stage, const FLatencyHistogram& Histogram)
+		{
+			Csv += FString::Printf(TEXT("%s,%s,%u,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f"), *Action.ToString(),
+			                       GetStageName(Stage), Histogram.Count, Histogram.MinMs, Histogram.GetMean(),
+			                       Histogram.GetPercentile(50.0), Histogram.GetPercentile(90.0),
+			                       Histogram.GetPercentile(99.0), Histogram.MaxMs);
+			for (const auto Count : Histogram.Bins)
+			{
+				Csv += FString::Printf(TEXT(",%u"), Count);
+			}
+			Csv += TEXT("\n");
+		});
+		if (FFileHelper::SaveStringToFile(Csv, *Path))
+		{
+			FP_DISPLAY("Wrote input latency to %s", *Path);
+		}
+		else
+		{
+			FP_ERROR("Failed to write input latency to %s", *Path);
+		}
+	}
+
+	static FAutoConsoleVariableRef CVarEnabled(
+		TEXT("FinePlay.InputLatency.Enable"), bEnabled,
+		TEXT("Measures latency from input events to handlers, applied input, ability activation and motion. "
+			"Enabling starts a new recording."),
+		FConsoleVariableDelegate::CreateLambda([](IConsoleVariable*)
+		{
+			if (bEnabled)
+			{
+				Reset();
+			}
+		}));
+
+	static FAutoConsoleCommand DumpCommand(
+		TEXT("FinePlay.InputLatency.Dump"),
+		TEXT("Writes recorded input latency per action and stage to the log."),
+		FConsoleCommandDelegate::CreateStatic(&Dump));
+
+	static FAutoConsoleCommand DumpCsvCommand(
+		TEXT("FinePlay.InputLatency.DumpCsv"),
+		TEXT("Writes recorded input latency histograms as CSV. Optional argument: file path, defaults to the "
+			"profiling directory."),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			DumpCsv(Args.IsEmpty() ? FString() : Args[0]);
+		}));
+
+	static FAutoConsoleCommand ResetCommand(
+		TEXT("FinePlay.InputLatency.Reset"),
+		TEXT("Clears recorded input latency."),
+		FConsoleCommandDelegate::CreateStatic(&Reset));
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFineInputLatencyTest, "FinePlay.Diagnostics.InputLatency",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+/// Sends input through the movement control of a possessing controller. Clears anything recorded before.
+bool FFineInputLatencyTest::RunTest(const FString& Parameters)
+{
+	using namespace FineInputLatency;
+
+	const FFineTestWorld World;
+	const auto Controller = World.Get()->SpawnActor<AFinePlayerController>();
+	const auto Character = World.SpawnCharacter(FVector::ZeroVector);
+	const auto CharacterGameplay = UFineCharacterGameplay::FindCharacterGameplay(Character);
+	const auto AbilitySystem = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Character);
+	if (!TestNotNull(TEXT("Controller"), Controller) || !TestNotNull(TEXT("Character gameplay"), CharacterGameplay) ||
+		!TestNotNull(TEXT("Ability system"), AbilitySystem))
+	{
+		return false;
+	}
+	constexpr int32 RunInputID = 1;
+	constexpr int32 JumpInputID = 2;
+	CharacterGameplay->AddAbilityByClass(UFineBenchmarkAbility::StaticClass(), 1, RunInputID);
+	CharacterGameplay->AddAbilityByClass(UFineBenchmarkAbility::StaticClass(), 1, JumpInputID);
+	const auto MovementControl = Controller->FindComponentByClass<UFineMovementInputControl>();
+	MovementControl->SetRunActionInputID(RunInputID);
+	MovementControl->SetJumpActionInputID(JumpInputID);
+	MovementControl->Activate(true);
+	Controller->Possess(Character);
+
+	const auto bWasEnabled = bEnabled;
+	bEnabled = true;
+	Reset();
+
+	// A blocked ability must not leave its chain running for the next action to end.
+	AbilitySystem->RemoveLooseGameplayTag(FinePlayGameplayTags::Actor_State_Alive);
+	MovementControl->ReplayInputEvent(EFineInputEvent::RunTriggered, FVector3f::ZeroVector);
+	TestNotNull(TEXT("Run handler histogram"), FindHistogram(TEXT("Run"), EFineInputLatencyStage::Handler));
+	TestNull(TEXT("Run activated histogram"), FindHistogram(TEXT("Run"), EFineInputLatencyStage::Activated));
+
+	AbilitySystem->AddLooseGameplayTag(FinePlayGameplayTags::Actor_State_Alive);
+	MovementControl->ReplayInputEvent(EFineInputEvent::JumpTriggered, FVector3f::ZeroVector);
+	for (const auto Stage : {EFineInputLatencyStage::Handler, EFineInputLatencyStage::Applied,
+	                         EFineInputLatencyStage::Activated})
+	{
+		const auto Histogram = FindHistogram(TEXT("Jump"), Stage);
+		if (TestNotNull(*FString::Printf(TEXT("Jump %s histogram"), GetStageName(Stage)), Histogram))
+		{
+			TestEqual(*FString::Printf(TEXT("Jump %s count"), GetStageName(Stage)), Histogram->Count, 1u);
+		}
+	}
+	// The chain ended at activation.
+	TestNull(TEXT("Jump motion histogram"), FindHistogram(TEXT("Jump"), EFineInputLatencyStage::Motion));
+	TestNull(TEXT("Run activated histogram after jump"),
+	         FindHistogram(TEXT("Run"), EFineInputLatencyStage::Activated));
+	const auto Applied = FindHistogram(TEXT("Jump"), EFineInputLatencyStage::Applied);
+	const auto Activated = FindHistogram(TEXT("Jump"), EFineInputLatencyStage::Activated);
+	if (Applied && Activated)
+	{
+		TestTrue(TEXT("Applied before activation"), Applied->MaxMs <= Activated->MinMs);
+	}
+	Reset();
+	bEnabled = bWasEnabled;
+	Controller->UnPossess();
+
+	FLatencyHistogram Histogram;
+	for (const auto Ms : {0.5, 3.0, 3.5, 20.0, 1000.0})
+	{
+		Histogram.Add(Ms);
+	}
+	TestEqual(TEXT("Count"), Histogram.Count, 5u);
+	TestEqual(TEXT("Min"), Histogram.MinMs, 0.5);
+	TestEqual(TEXT("Max"), Histogram.MaxMs, 1000.0);
+	TestEqual(TEXT("P50"), Histogram.GetPercentile(50.0), 4.0);
+	TestEqual(TEXT("P100"), Histogram.GetPercentile(100.0), 1000.0);
+
+	return true;
+}
+
+#endif
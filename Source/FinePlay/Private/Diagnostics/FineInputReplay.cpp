@@ -0,0 +1,458 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Diagnostics/FineInputReplay.h"
+
+#include "FinePlayLog.h"
+#include "Control/FineCommonInputControl.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace FineInputReplay
+{
+	constexpr uint32 FileMagic = 0x52495046; // "FPIR"
+	constexpr uint16 FileVersion = 1;
+
+	struct FRecordedEvent
+	{
+		EFineInputEvent Type = EFineInputEvent::InputStarted;
+		/// Index into FRecording::Controls.
+		uint8 Control = 0;
+		FVector3f Value = FVector3f::ZeroVector;
+
+		FORCEINLINE bool IsCursor() const
+		{
+			return Type == EFineInputEvent::CursorHit || Type == EFineInputEvent::CursorMiss;
+		}
+
+		friend FArchive& operator<<(FArchive& Ar, FRecordedEvent& Event)
+		{
+			Ar << Event.Type;
+			Ar << Event.Control;
+			// Only events that carry a value store it.
+			if (Event.Type == EFineInputEvent::WalkTriggered)
+			{
+				Ar << Event.Value.X;
+				Ar << Event.Value.Y;
+			}
+			else if (Event.Type == EFineInputEvent::CursorHit)
+			{
+				Ar << Event.Value;
+			}
+			return Ar;
+		}
+	};
+
+	struct FRecording
+	{
+		FString MapName;
+		/// Names of the recorded input controls of the controller.
+		TArray<FName> Controls;
+		TArray<float> FrameDeltas;
+		TArray<uint16> FrameEventCounts;
+		TArray<FRecordedEvent> Events;
+
+		void Reset()
+		{
+			MapName.Reset();
+			Controls.Reset();
+			FrameDeltas.Reset();
+			FrameEventCounts.Reset();
+			Events.Reset();
+		}
+
+		friend FArchive& operator<<(FArchive& Ar, FRecording& Recording)
+		{
+			Ar << Recording.MapName;
+			Ar << Recording.Controls;
+			Ar << Recording.FrameDeltas;
+			Ar << Recording.FrameEventCounts;
+			auto Num = Recording.Events.Num();
+			Ar << Num;
+			if (Ar.IsLoading())
+			{
+				// Every event takes at least a byte, so more events than bytes left means a corrupt file.
+				if (Num < 0 || Num > Ar.TotalSize() - Ar.Tell())
+				{
+					Ar.SetError();
+					return Ar;
+				}
+				Recording.Events.SetNum(Num);
+			}
+			for (auto& Event : Recording.Events)
+			{
+				Ar << Event;
+			}
+			return Ar;
+		}
+	};
+
+	enum class EMode : uint8
+	{
+		Idle,
+		Recording,
+		Replaying,
+	};
+
+	EMode Mode = EMode::Idle;
+	FRecording Recording;
+	FString RecordingPath;
+	/// Controller being recorded or replayed. Bound on its first frame.
+	TWeakObjectPtr<APlayerController> BoundController;
+	int32 Frame = 0;
+	/// Replay: first event of the current frame. Recording: events of the current frame so far.
+	int32 FrameEventIndex = 0;
+	TArray<FRecordedEvent> PendingCursorLocations;
+	int32 PendingCursorIndex = 0;
+	bool bExitWhenDone = false;
+	bool bWasFixedTimeStep = false;
+	double PreviousFixedDeltaTime = 0.0;
+	bool bCheckedCommandLine = false;
+
+	bool IsBound(const UActorComponent* Control)
+	{
+		return IsValid(Control) && BoundController.IsValid() && Control->GetOwner() == BoundController.Get();
+	}
+
+	void StartRecording(const FString& Path)
+	{
+		if (Mode != EMode::Idle)
+		{
+			FP_WARNING("Input replay is busy, stop it before recording.");
+			return;
+		}
+		Recording.Reset();
+		RecordingPath = Path.IsEmpty()
+			                ? FPaths::ProfilingDir() / TEXT("FinePlay") / FString::Printf(
+				                TEXT("Input-%s.fpinput"), *FDateTime::Now().ToString())
+			                : Path;
+		BoundController = nullptr;
+		Frame = 0;
+		FrameEventIndex = 0;
+		Mode = EMode::Recording;
+		FP_DISPLAY("Recording input to %s", *RecordingPath);
+	}
+
+	void StopRecording()
+	{
+		if (Mode != EMode::Recording)
+		{
+			return;
+		}
+		Mode = EMode::Idle;
+		BoundController = nullptr;
+		if (Recording.FrameDeltas.Num() > 0)
+		{
+			Recording.FrameEventCounts.Add(static_cast<uint16>(FrameEventIndex));
+		}
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer(Bytes);
+		auto Magic = FileMagic;
+		auto Version = FileVersion;
+		Writer << Magic;
+		Writer << Version;
+		Writer << Recording;
+		if (FFileHelper::SaveArrayToFile(Bytes, *RecordingPath))
+		{
+			FP_DISPLAY("Wrote %d frames and %d input events to %s", Recording.FrameDeltas.Num(),
+			           Recording.Events.Num(), *RecordingPath);
+		}
+		else
+		{
+			FP_ERROR("Failed to write input recording to %s", *RecordingPath);
+		}
+		Recording.Reset();
+	}
+
+	void StartReplay(const FString& Path, const bool bInExitWhenDone)
+	{
+		if (Mode != EMode::Idle)
+		{
+			FP_WARNING("Input replay is busy, stop it before replaying.");
+			return;
+		}
+		TArray<uint8> Bytes;
+		if (!FFileHelper::LoadFileToArray(Bytes, *Path))
+		{
+			FP_ERROR("Failed to read input recording %s", *Path);
+			return;
+		}
+		FMemoryReader Reader(Bytes);
+		uint32 Magic = 0;
+		uint16 Version = 0;
+		Reader << Magic;
+		Reader << Version;
+		if (Magic != FileMagic || Version != FileVersion)
+		{
+			FP_ERROR("%s isn't a FinePlay input recording of version %d.", *Path, FileVersion);
+			return;
+		}
+		Recording.Reset();
+		Reader << Recording;
+		int64 RecordedEvents = 0;
+		for (const auto Count : Recording.FrameEventCounts)
+		{
+			RecordedEvents += Count;
+		}
+		if (Reader.IsError() || Recording.FrameDeltas.Num() != Recording.FrameEventCounts.Num() ||
+			RecordedEvents != Recording.Events.Num())
+		{
+			FP_ERROR("Input recording %s is corrupt.", *Path);
+			Recording.Reset();
+			return;
+		}
+		BoundController = nullptr;
+		Frame = 0;
+		FrameEventIndex = 0;
+		bExitWhenDone = bInExitWhenDone;
+		// Replay the recorded frame deltas.
+		bWasFixedTimeStep = FApp::UseFixedTimeStep();
+		PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+		FApp::SetUseFixedTimeStep(true);
+		if (Recording.FrameDeltas.Num() > 0)
+		{
+			FApp::SetFixedDeltaTime(Recording.FrameDeltas[0]);
+		}
+		Mode = EMode::Replaying;
+		FP_DISPLAY("Replaying %d frames of input from %s", Recording.FrameDeltas.Num(), *Path);
+	}
+
+	void StopReplay()
+	{
+		if (Mode != EMode::Replaying)
+		{
+			return;
+		}
+		Mode = EMode::Idle;
+		BoundController = nullptr;
+		PendingCursorLocations.Reset();
+		FApp::SetUseFixedTimeStep(bWasFixedTimeStep);
+		FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+		FP_DISPLAY("Input replay finished after %d frames.", Frame);
+		Recording.Reset();
+		if (bExitWhenDone)
+		{
+			FPlatformMisc::RequestExit(false);
+		}
+	}
+
+	void ReplayFrame(APlayerController* Controller)
+	{
+		if (Frame >= Recording.FrameDeltas.Num())
+		{
+			StopReplay();
+			return;
+		}
+		if (Recording.FrameDeltas.IsValidIndex(Frame + 1))
+		{
+			FApp::SetFixedDeltaTime(Recording.FrameDeltas[Frame + 1]);
+		}
+		const auto FirstEvent = FrameEventIndex;
+		const auto NumEvents = Recording.FrameEventCounts[Frame];
+		FrameEventIndex += NumEvents;
+		Frame++;
+
+		// Handlers consume the cursor locations of the frame in recorded order.
+		PendingCursorLocations.Reset();
+		PendingCursorIndex = 0;
+		for (int32 Index = FirstEvent; Index < FirstEvent + NumEvents; ++Index)
+		{
+			if (Recording.Events[Index].IsCursor())
+			{
+				PendingCursorLocations.Add(Recording.Events[Index]);
+			}
+		}
+		TInlineComponentArray<UFineCommonInputControl*> Controls(Controller);
+		for (int32 Index = FirstEvent; Index < FirstEvent + NumEvents; ++Index)
+		{
+			const auto& Event = Recording.Events[Index];
+			if (Event.IsCursor() || !Recording.Controls.IsValidIndex(Event.Control))
+			{
+				continue;
+			}
+			const auto ControlName = Recording.Controls[Event.Control];
+			for (const auto Control : Controls)
+			{
+				if (Control->GetFName() == ControlName)
+				{
+					Control->ReplayInputEvent(Event.Type, Event.Value);
+					break;
+				}
+			}
+		}
+	}
+
+	bool TickFrame(APlayerController* Controller, const float DeltaTime)
+	{
+		if (!bCheckedCommandLine)
+		{
+			bCheckedCommandLine = true;
+			FString Path;
+			if (FParse::Value(FCommandLine::Get(), TEXT("FinePlayReplay="), Path))
+			{
+				StartReplay(Path, true);
+			}
+			else if (FParse::Value(FCommandLine::Get(), TEXT("FinePlayRecord="), Path))
+			{
+				StartRecording(Path);
+			}
+		}
+		if (Mode == EMode::Idle || !IsValid(Controller) || !Controller->IsLocalController())
+		{
+			return false;
+		}
+		if (!BoundController.IsValid())
+		{
+			BoundController = Controller;
+			const auto MapName = UWorld::RemovePIEPrefix(Controller->GetWorld()->GetMapName());
+			if (Mode == EMode::Recording)
+			{
+				Recording.MapName = MapName;
+			}
+			else if (Recording.MapName != MapName)
+			{
+				FP_WARNING("Replaying input recorded on %s on %s.", *Recording.MapName, *MapName);
+			}
+		}
+		if (BoundController.Get() != Controller)
+		{
+			return false;
+		}
+		if (Mode == EMode::Recording)
+		{
+			if (Recording.FrameDeltas.Num() > 0)
+			{
+				Recording.FrameEventCounts.Add(static_cast<uint16>(FrameEventIndex));
+			}
+			Recording.FrameDeltas.Add(DeltaTime);
+			FrameEventIndex = 0;
+			return false;
+		}
+		ReplayFrame(Controller);
+		return true;
+	}
+
+	void StopController(const APlayerController* Controller)
+	{
+		if (!BoundController.IsValid() || BoundController.Get() != Controller)
+		{
+			return;
+		}
+		StopRecording();
+		StopReplay();
+	}
+
+	bool IsRecording()
+	{
+		return Mode == EMode::Recording;
+	}
+
+	bool IsReplaying()
+	{
+		return Mode == EMode::Replaying;
+	}
+
+	void RecordEvent(const UActorComponent* Control, const EFineInputEvent Event, const FVector3f& Value)
+	{
+		// Events before the first frame have no frame to belong to.
+		if (Mode != EMode::Recording || !IsBound(Control) || Recording.FrameDeltas.IsEmpty() ||
+			FrameEventIndex == MAX_uint16)
+		{
+			return;
+		}
+		auto ControlIndex = Recording.Controls.Find(Control->GetFName());
+		if (ControlIndex == INDEX_NONE)
+		{
+			if (Recording.Controls.Num() > MAX_uint8)
+			{
+				return;
+			}
+			ControlIndex = Recording.Controls.Add(Control->GetFName());
+		}
+		auto& Recorded = Recording.Events.AddDefaulted_GetRef();
+		Recorded.Type = Event;
+		Recorded.Control = static_cast<uint8>(ControlIndex);
+		Recorded.Value = Value;
+		FrameEventIndex++;
+	}
+
+	void RecordCursorLocation(const UActorComponent* Control, const bool bHit, const FVector& Location)
+	{
+		RecordEvent(Control, bHit ? EFineInputEvent::CursorHit : EFineInputEvent::CursorMiss,
+		            bHit ? FVector3f(Location) : FVector3f::ZeroVector);
+	}
+
+	bool ConsumeCursorLocation(const UActorComponent* Control, bool& bOutHit, FVector& OutLocation)
+	{
+		if (Mode != EMode::Replaying || !IsBound(Control))
+		{
+			return false;
+		}
+		if (!PendingCursorLocations.IsValidIndex(PendingCursorIndex))
+		{
+			// The handler asked more often than it did while recording.
+			bOutHit = false;
+			return true;
+		}
+		const auto& Event = PendingCursorLocations[PendingCursorIndex++];
+		bOutHit = Event.Type == EFineInputEvent::CursorHit;
+		OutLocation = FVector(Event.Value);
+		return true;
+	}
+
+	int32 FScopedHandler::Depth = 0;
+
+	FScopedHandler::FScopedHandler(const UActorComponent* Control, const EFineInputEvent Event,
+	                               const FVector3f& Value)
+	{
+		if (Depth++ == 0 && Mode == EMode::Recording)
+		{
+			RecordEvent(Control, Event, Value);
+		}
+	}
+
+	FScopedHandler::~FScopedHandler()
+	{
+		Depth--;
+	}
+
+	static FAutoConsoleCommand RecordCommand(
+		TEXT("FinePlay.Input.Record"),
+		TEXT("Records the input of the local FinePlay player controller. Optional argument: file path, defaults to "
+			"the profiling directory."),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			StartRecording(Args.IsEmpty() ? FString() : Args[0]);
+		}));
+
+	static FAutoConsoleCommand StopRecordingCommand(
+		TEXT("FinePlay.Input.StopRecording"),
+		TEXT("Stops recording input and writes the recording."),
+		FConsoleCommandDelegate::CreateStatic(&StopRecording));
+
+	static FAutoConsoleCommand ReplayCommand(
+		TEXT("FinePlay.Input.Replay"),
+		TEXT("Replays recorded input on the local FinePlay player controller. Argument: file path."),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			if (Args.IsEmpty())
+			{
+				FP_WARNING("FinePlay.Input.Replay needs the path of a recording.");
+				return;
+			}
+			StartReplay(Args[0], false);
+		}));
+
+	static FAutoConsoleCommand StopReplayCommand(
+		TEXT("FinePlay.Input.StopReplay"),
+		TEXT("Stops replaying input."),
+		FConsoleCommandDelegate::CreateStatic(&StopReplay));
+}
@@ -0,0 +1,66 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Diagnostics/FinePlayEventRing.h"
+
+#include "FinePlayLog.h"
+#include "HAL/IConsoleManager.h"
+
+static_assert(FMath::IsPowerOfTwo(FFinePlayEventRing::Capacity), "Capacity is used as a mask.");
+
+FFinePlayEventRing& FFinePlayEventRing::Get()
+{
+	static FFinePlayEventRing Instance;
+	return Instance;
+}
+
+void FFinePlayEventRing::Record(const TCHAR* Event, const FName& Name, double Value)
+{
+	const auto Index = Head.fetch_add(1, std::memory_order_relaxed);
+	auto& Entry = Entries[Index & (Capacity - 1)];
+	Entry.Sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	Entry.Cycles = FPlatformTime::Cycles64();
+	Entry.Event = Event;
+	Entry.Name = Name;
+	Entry.Value = Value;
+	Entry.ThreadId = FPlatformTLS::GetCurrentThreadId();
+	Entry.Sequence.store(Index + 1, std::memory_order_release);
+}
+
+void FFinePlayEventRing::Dump(int32 Count) const
+{
+	const auto End = Head.load(std::memory_order_acquire);
+	const auto Num = FMath::Min<uint64>(FMath::Min<uint64>(FMath::Max(Count, 0), Capacity), End);
+	const auto EndCycles = FPlatformTime::Cycles64();
+	FP_DISPLAY("Last %llu of %llu FinePlay events:", Num, End);
+	for (auto Index = End - Num; Index < End; ++Index)
+	{
+		const auto& Entry = Entries[Index & (Capacity - 1)];
+		if (Entry.Sequence.load(std::memory_order_acquire) != Index + 1)
+		{
+			continue;
+		}
+		// Copy, then make sure the writer didn't start over meanwhile.
+		const auto Cycles = Entry.Cycles;
+		const auto Event = Entry.Event;
+		const auto Name = Entry.Name;
+		const auto Value = Entry.Value;
+		const auto ThreadId = Entry.ThreadId;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (Entry.Sequence.load(std::memory_order_relaxed) != Index + 1)
+		{
+			continue;
+		}
+		FP_DISPLAY("%10.3f ms ago [%u] %s %s %g", FPlatformTime::ToMilliseconds64(EndCycles - Cycles), ThreadId,
+		           Event, *Name.ToString(), Value);
+	}
+}
+
+static FAutoConsoleCommand FinePlayDumpEventsCommand(
+	TEXT("FinePlay.Log.DumpEvents"),
+	TEXT("Writes the last recorded FinePlay events to the log. Optional argument: number of events."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FFinePlayEventRing::Get().Dump(Args.IsEmpty() ? FFinePlayEventRing::Capacity : FCString::Atoi(*Args[0]));
+	}));
@@ -0,0 +1,30 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Diagnostics/FinePlayStats.h"
+
+DEFINE_STAT(STAT_FinePlay_SceneTransition);
+DEFINE_STAT(STAT_FinePlay_DatabaseLookup);
+DEFINE_STAT(STAT_FinePlay_AbilityGrant);
+DEFINE_STAT(STAT_FinePlay_AbilityActivation);
+DEFINE_STAT(STAT_FinePlay_MovementInput);
+DEFINE_STAT(STAT_FinePlay_CursorTrace);
+DEFINE_STAT(STAT_FinePlay_AnimationUpdate);
+DEFINE_STAT(STAT_FinePlay_MPCUpdate);
+DEFINE_STAT(STAT_FinePlay_ResourceRegen);
+
+DEFINE_STAT(STAT_FinePlay_SceneTransitionCalls);
+DEFINE_STAT(STAT_FinePlay_DatabaseLookupCalls);
+DEFINE_STAT(STAT_FinePlay_AbilityGrantCalls);
+DEFINE_STAT(STAT_FinePlay_AbilityActivationCalls);
+DEFINE_STAT(STAT_FinePlay_MovementInputCalls);
+DEFINE_STAT(STAT_FinePlay_CursorTraceCalls);
+DEFINE_STAT(STAT_FinePlay_AnimationUpdateCalls);
+DEFINE_STAT(STAT_FinePlay_MPCUpdateCalls);
+
+DEFINE_STAT(STAT_FinePlay_InputToHandler);
+DEFINE_STAT(STAT_FinePlay_InputToApplied);
+DEFINE_STAT(STAT_FinePlay_InputToActivation);
+DEFINE_STAT(STAT_FinePlay_InputToMotion);
+
+UE_TRACE_CHANNEL_DEFINE(FinePlayChannel);
@@ -0,0 +1,63 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Actor/FineCharacterGameplay.h"
+#include "Actor/FinePaperCharacter.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+/**
+ * Game world owned by an automation test, so that tests don't depend on a loaded map. Play begins on creation, and
+ * the world is destroyed with this object.
+ */
+class FFineTestWorld
+{
+public:
+	FFineTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("FineTestWorld"));
+		auto& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+	}
+
+	~FFineTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	FFineTestWorld(const FFineTestWorld&) = delete;
+	FFineTestWorld& operator=(const FFineTestWorld&) = delete;
+
+	FORCEINLINE UWorld* Get() const { return World; }
+
+	void Tick(float DeltaSeconds) const
+	{
+		World->Tick(LEVELTICK_All, DeltaSeconds);
+	}
+
+	/// Spawns a character with a character gameplay component, which games add in their character blueprints.
+	AFinePaperCharacter* SpawnCharacter(const FVector& Location) const
+	{
+		const FTransform Transform(Location);
+		const auto Character = World->SpawnActorDeferred<AFinePaperCharacter>(
+			AFinePaperCharacter::StaticClass(), Transform, nullptr, nullptr,
+			ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+		const auto CharacterGameplay = NewObject<UFineCharacterGameplay>(Character, TEXT("CharacterGameplay"));
+		Character->AddInstanceComponent(CharacterGameplay);
+		Character->FinishSpawning(Transform);
+		return Character;
+	}
+
+private:
+	UWorld* World;
+};
+
+#endif
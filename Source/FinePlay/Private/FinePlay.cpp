@@ -19,4 +19,7 @@ void FFinePlayModule::ShutdownModule()
 #undef LOCTEXT_NAMESPACE
 	
 IMPLEMENT_MODULE(FFinePlayModule, FinePlay)
-DEFINE_LOG_CATEGORY(LogFinePlay);
\ No newline at end of file
+DEFINE_LOG_CATEGORY(LogFinePlay);
+DEFINE_LOG_CATEGORY(LogFinePlayAbility);
+DEFINE_LOG_CATEGORY(LogFinePlayAttribute);
+DEFINE_LOG_CATEGORY(LogFinePlayInput);
\ No newline at end of file
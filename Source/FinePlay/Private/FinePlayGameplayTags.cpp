@@ -0,0 +1,32 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "FinePlayGameplayTags.h"
+
+#include "FinePlayLog.h"
+
+namespace FinePlayGameplayTags
+{
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Actor_State_Alive, "Actor.State.Alive", "Actor is alive.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Actor_State_Invincible, "Actor.State.Invincible", "Actor doesn't take damage.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Actor_State_Moving, "Actor.State.Moving", "Actor is moving.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Actor_State_Running, "Actor.State.Running", "Actor is running.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Actor_State_Jumping, "Actor.State.Jumping", "Actor is jumping.");
+	UE_DEFINE_GAMEPLAY_TAG_COMMENT(Actor_State_Exhausted, "Actor.State.Exhausted", "Actor's stamina is not full.");
+
+	FGameplayTag ResolveTag(const FName& TagName, const FGameplayTag& NativeTag)
+	{
+		if (TagName.IsNone() || TagName == NativeTag.GetTagName())
+		{
+			return NativeTag;
+		}
+		const auto Tag = FGameplayTag::RequestGameplayTag(TagName, false);
+		if (!Tag.IsValid())
+		{
+			FP_ERROR("Unknown gameplay tag: %s, falling back to %s", *TagName.ToString(),
+			         *NativeTag.GetTagName().ToString());
+			return NativeTag;
+		}
+		return Tag;
+	}
+}
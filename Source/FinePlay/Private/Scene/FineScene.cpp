@@ -7,6 +7,7 @@
 #include "FineGameState.h"
 #include "FinePlayLog.h"
 #include "FineSaveGameComponent.h"
+#include "Diagnostics/FinePlayStats.h"
 #include "GameFramework/GameModeBase.h"
 #include "GameFramework/GameStateBase.h"
 #include "GameFramework/PlayerStart.h"
@@ -103,6 +104,7 @@ void AFineScene::OnLoadingFinished_Implementation()
 
 void AFineScene::TryTeleportToScene()
 {
+	FP_SCOPE_CYCLE(SceneTransition);
 	if (NeedsToLoadGameData())
 	{
 		FP_LOG("Cannot teleport to the scene's player start yet. game data is not loaded.");
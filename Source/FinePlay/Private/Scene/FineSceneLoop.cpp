@@ -3,6 +3,7 @@
 
 #include "Scene/FineSceneLoop.h"
 
+#include "Diagnostics/FinePlayStats.h"
 #include "GameFramework/GameStateBase.h"
 #include "Kismet/GameplayStatics.h"
 #include "Scene/FineScene.h"
@@ -46,6 +47,7 @@ void UFineSceneLoop::PopScene()
 
 void UFineSceneLoop::PlayNext()
 {
+	FP_SCOPE_CALL(SceneTransition);
 	DestroyCurrentScene();
 	// if scene classes are empty, return
 	if (SceneClasses.Num() == 0)
@@ -3,6 +3,8 @@
 
 #include "Utilities/FineAnimationComponent.h"
 
+#include "Diagnostics/FinePlayStats.h"
+
 UFineAnimationComponent::UFineAnimationComponent(): Super()
 {
 }
@@ -14,7 +16,7 @@ void UFineAnimationComponent::PlayAnimation_Implementation()
 	CurrentLoopCount = 0;
 	OnAnimationStarted.Broadcast();
 	OnAnimationLoopStarted.Broadcast();
-	GetWorld()->GetTimerManager().SetTimer(AnimTimerHandle, this, &UFineAnimationComponent::UpdateAnimation, Interval,
+	GetWorld()->GetTimerManager().SetTimer(AnimTimerHandle, this, &UFineAnimationComponent::OnAnimationTimer, Interval,
 	                                       true);
 }
 
@@ -43,6 +45,13 @@ void UFineAnimationComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 	Super::EndPlay(EndPlayReason);
 }
 
+void UFineAnimationComponent::OnAnimationTimer()
+{
+	// Scoped here rather than in UpdateAnimation so overrides are timed once, including their Super call.
+	FP_SCOPE_CALL(AnimationUpdate);
+	UpdateAnimation();
+}
+
 void UFineAnimationComponent::UpdateAnimation()
 {
 	Elapsed = FMath::Clamp(Elapsed + Interval, 0, Duration);
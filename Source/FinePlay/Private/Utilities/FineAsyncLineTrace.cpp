@@ -0,0 +1,48 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+
+#include "Utilities/FineAsyncLineTrace.h"
+
+#include "Engine/World.h"
+
+void FFineAsyncLineTrace::Request(UWorld* World, const FVector& Start, const FVector& End, ECollisionChannel Channel,
+                                  const FCollisionQueryParams& Params)
+{
+	if (!IsValid(World) || (PendingHandle.IsValid() && PendingFrame == GFrameCounter))
+	{
+		return;
+	}
+	PendingHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Start, End, Channel, Params);
+	PendingFrame = GFrameCounter;
+}
+
+bool FFineAsyncLineTrace::Consume(const UWorld* World, FHitResult& OutHit, bool& bOutHit, uint64 MaxAge)
+{
+	if (PendingHandle.IsValid() && PendingFrame < GFrameCounter && IsValid(World))
+	{
+		// Trace data is kept for one frame only, an older handle can't be queried anymore.
+		FTraceDatum Datum;
+		if (World->QueryTraceData(PendingHandle, Datum))
+		{
+			bHit = Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit;
+			Hit = bHit ? Datum.OutHits[0] : FHitResult();
+			bHasResult = true;
+			ResultFrame = PendingFrame;
+		}
+		PendingHandle.Invalidate();
+	}
+	if (!bHasResult || GFrameCounter - ResultFrame > MaxAge)
+	{
+		return false;
+	}
+	OutHit = Hit;
+	bOutHit = bHit;
+	return true;
+}
+
+void FFineAsyncLineTrace::Reset()
+{
+	PendingHandle.Invalidate();
+	bHasResult = false;
+	bHit = false;
+}
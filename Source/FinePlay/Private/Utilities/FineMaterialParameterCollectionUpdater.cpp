@@ -4,6 +4,7 @@
 #include "Utilities/FineMaterialParameterCollectionUpdater.h"
 
 #include "FinePlayLog.h"
+#include "Diagnostics/FinePlayStats.h"
 #include "Engine/AssetManager.h"
 #include "Engine/StreamableManager.h"
 #include "Materials/MaterialParameterCollection.h"
@@ -31,6 +32,7 @@ void UFineMaterialParameterCollectionUpdater::EndUpdating()
 
 void UFineMaterialParameterCollectionUpdater::UpdateMaterialParameterCollection_Implementation()
 {
+	FP_SCOPE_CALL(MPCUpdate);
 	if (!IsValid(MaterialParameterCollection))
 	{
 		// Try to load synchronously.
@@ -3,8 +3,11 @@
 
 #include "Utilities/FinePlayFunctionLibrary.h"
 
+#include "AbilitySystemBlueprintLibrary.h"
+#include "AbilitySystemComponent.h"
 #include "FineCountedFlag.h"
 #include "FinePlayLog.h"
+#include "Actor/FineCharacterGameplay.h"
 #include "GameFramework/Character.h"
 #include "GameFramework/GameStateBase.h"
 #include "Kismet/GameplayStatics.h"
@@ -86,3 +89,61 @@ bool UFinePlayFunctionLibrary::GetUserInputEnabled(AActor* Actor)
 	}
 	return false;
 }
+
+int32 UFinePlayFunctionLibrary::ApplyGameplayEffectToTargets(UAbilitySystemComponent* SourceAbilitySystem,
+                                                             TSubclassOf<UGameplayEffect> EffectClass, float Level,
+                                                             const TArray<AActor*>& Targets,
+                                                             bool bSkipDeadOrInvincible)
+{
+	if (!IsValid(SourceAbilitySystem) || !EffectClass)
+	{
+		FP_ERROR("Invalid source ability system or effect class.");
+		return 0;
+	}
+	// One spec and one context for all targets.
+	const auto SpecHandle = SourceAbilitySystem->MakeOutgoingSpec(EffectClass, Level,
+	                                                              SourceAbilitySystem->MakeEffectContext());
+	return ApplyGameplayEffectSpecToTargets(SpecHandle, Targets, bSkipDeadOrInvincible);
+}
+
+int32 UFinePlayFunctionLibrary::ApplyGameplayEffectSpecToTargets(const FGameplayEffectSpecHandle& SpecHandle,
+                                                                 const TArray<AActor*>& Targets,
+                                                                 bool bSkipDeadOrInvincible)
+{
+	const auto Spec = SpecHandle.Data.Get();
+	if (Spec == nullptr)
+	{
+		FP_ERROR("Invalid gameplay effect spec.");
+		return 0;
+	}
+	int32 AppliedCount = 0;
+	for (const auto Target : Targets)
+	{
+		if (!IsValid(Target))
+		{
+			continue;
+		}
+		UAbilitySystemComponent* TargetAbilitySystem;
+		if (const auto CharacterGameplay = UFineCharacterGameplay::FindCharacterGameplay(Target))
+		{
+			// State flags instead of tag lookups.
+			const auto States = CharacterGameplay->GetStateFlags();
+			if (bSkipDeadOrInvincible && (!EnumHasAnyFlags(States, EFineCharacterState::Alive) ||
+				EnumHasAnyFlags(States, EFineCharacterState::Invincible)))
+			{
+				continue;
+			}
+			TargetAbilitySystem = CharacterGameplay->SetAndGetAbilitySystemComponent();
+		}
+		else
+		{
+			TargetAbilitySystem = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(Target);
+		}
+		if (IsValid(TargetAbilitySystem))
+		{
+			TargetAbilitySystem->ApplyGameplayEffectSpecToSelf(*Spec);
+			++AppliedCount;
+		}
+	}
+	return AppliedCount;
+}
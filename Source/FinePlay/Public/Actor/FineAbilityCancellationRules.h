@@ -0,0 +1,70 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AttributeSet.h"
+#include "GameplayAbilitySpecHandle.h"
+#include "GameplayTagContainer.h"
+#include "FineAbilityCancellationRules.generated.h"
+
+class FFineAbilityRegistry;
+class UAbilitySystemComponent;
+
+/**
+ * Cancels abilities when an attribute drops to a threshold, e.g. running when stamina is depleted.
+ */
+USTRUCT(BlueprintType)
+struct FINEPLAY_API FFineAbilityCancellationRule
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "FineAbilityCancellationRule")
+	FGameplayAttribute Attribute;
+	/// Abilities are cancelled when the attribute changes to this value or below.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "FineAbilityCancellationRule")
+	float Threshold = 0.f;
+	/// Cancels abilities having any of these tags.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "FineAbilityCancellationRule")
+	FGameplayTagContainer CancelAbilitiesWithTags;
+	/// Cancels abilities granted with this input ID.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "FineAbilityCancellationRule")
+	int32 CancelInputID = INDEX_NONE;
+};
+
+/**
+ * Cancellation rules of a character, compiled to ability spec handles so that evaluating them needs no lookups.
+ */
+class FINEPLAY_API FFineAbilityCancellationRules
+{
+public:
+	/// Returns the ID to remove the rule with.
+	int32 Add(const FFineAbilityCancellationRule& Rule);
+	bool Remove(int32 RuleID);
+	void Reset();
+
+	FORCEINLINE bool IsEmpty() const { return Rules.IsEmpty(); }
+
+	/// Resolves the abilities of every rule to spec handles. Call after abilities are granted or revoked.
+	void Compile(UAbilitySystemComponent* AbilitySystem, const FFineAbilityRegistry& Registry);
+
+	/// Attributes watched by any rule, without duplicates.
+	void GetAttributes(TArray<FGameplayAttribute>& OutAttributes) const;
+
+	/// Cancels the abilities of the rules on the attribute whose threshold the value reached.
+	void Evaluate(UAbilitySystemComponent* AbilitySystem, const FGameplayAttribute& Attribute, float NewValue) const;
+
+private:
+	struct FCompiledRule
+	{
+		int32 ID = INDEX_NONE;
+		FFineAbilityCancellationRule Rule;
+		TArray<FGameplayAbilitySpecHandle> Handles;
+	};
+
+	void CompileRule(FCompiledRule& CompiledRule, UAbilitySystemComponent* AbilitySystem,
+	                 const FFineAbilityRegistry& Registry) const;
+
+	TArray<FCompiledRule> Rules;
+	int32 NextID = 0;
+};
@@ -0,0 +1,97 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayAbilitySpecHandle.h"
+#include "UObject/ObjectKey.h"
+#include "FineAbilityRegistry.generated.h"
+
+class UGameplayAbility;
+
+/**
+ * Describes an ability to grant through UFineCharacterGameplay::GrantAbilities.
+ */
+USTRUCT(BlueprintType)
+struct FINEPLAY_API FFineAbilityGrant
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "FineAbilityRegistry")
+	TSubclassOf<UGameplayAbility> AbilityClass;
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "FineAbilityRegistry")
+	int32 Level = 1;
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "FineAbilityRegistry")
+	int32 InputID = INDEX_NONE;
+	/// Defaults to the character gameplay component granting the ability.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "FineAbilityRegistry")
+	TObjectPtr<UObject> SourceObject;
+};
+
+/**
+ * An ability granted by FinePlay.
+ */
+struct FINEPLAY_API FFineAbilityRegistryEntry
+{
+	FGameplayAbilitySpecHandle Handle;
+	const UClass* AbilityClass = nullptr;
+	int32 InputID = INDEX_NONE;
+	FObjectKey SourceObject;
+	/// Increases with each grant, to keep lookups in grant order.
+	uint64 GrantOrder = 0;
+};
+
+/**
+ * Keeps the abilities granted by a character gameplay component, indexed by handle, class, input ID and source
+ * object, so that lookups don't need to scan the ability system's spec list.
+ */
+class FINEPLAY_API FFineAbilityRegistry
+{
+public:
+	typedef TArray<FGameplayAbilitySpecHandle, TInlineAllocator<1>> FHandleList;
+
+	void Add(const FGameplayAbilitySpecHandle& Handle, const UClass* AbilityClass, int32 InputID,
+	         const UObject* SourceObject);
+	bool Remove(const FGameplayAbilitySpecHandle& Handle);
+	void Reset();
+
+	FORCEINLINE int32 Num() const { return Entries.Num(); }
+	FORCEINLINE bool Contains(const FGameplayAbilitySpecHandle& Handle) const { return Entries.Contains(Handle); }
+	FORCEINLINE const FFineAbilityRegistryEntry* Find(const FGameplayAbilitySpecHandle& Handle) const
+	{
+		return Entries.Find(Handle);
+	}
+
+	/// Handles granted with exactly the given class, in grant order. Same for the other lookups.
+	const FHandleList* FindByClass(const UClass* AbilityClass) const { return ByClass.Find(AbilityClass); }
+	/// Handles granted with the given class or any of its subclasses, in grant order.
+	void FindByClassOrSubclass(const UClass* AbilityClass, TArray<FGameplayAbilitySpecHandle>& OutHandles) const;
+	const FHandleList* FindByInputID(int32 InputID) const { return ByInputID.Find(InputID); }
+	const FHandleList* FindBySourceObject(const UObject* SourceObject) const
+	{
+		return BySourceObject.Find(FObjectKey(SourceObject));
+	}
+
+	void GetHandles(TArray<FGameplayAbilitySpecHandle>& OutHandles) const;
+
+private:
+	template <typename KeyType>
+	static void RemoveFromIndex(TMap<KeyType, FHandleList>& Index, const KeyType& Key,
+	                            const FGameplayAbilitySpecHandle& Handle)
+	{
+		if (auto List = Index.Find(Key))
+		{
+			List->RemoveSingle(Handle);
+			if (List->IsEmpty())
+			{
+				Index.Remove(Key);
+			}
+		}
+	}
+
+	TMap<FGameplayAbilitySpecHandle, FFineAbilityRegistryEntry> Entries;
+	TMap<const UClass*, FHandleList> ByClass;
+	TMap<int32, FHandleList> ByInputID;
+	TMap<FObjectKey, FHandleList> BySourceObject;
+	uint64 NextGrantOrder = 0;
+};
@@ -0,0 +1,120 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/FineDisplayData.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/Object.h"
+#include "FineActorArchetype.generated.h"
+
+class UFineLocalDatabaseComponent;
+class UGameplayAbility;
+
+/**
+ * Base attribute values for a character, read from "CharacterAttributeSet" entity.
+ */
+USTRUCT(BlueprintType)
+struct FINEPLAY_API FFineCharacterAttributeData
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "FineActorArchetype")
+	float Health = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineActorArchetype")
+	float Mana = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineActorArchetype")
+	float MovementSpeed = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineActorArchetype")
+	float AttackPower = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineActorArchetype")
+	float DefensePower = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineActorArchetype")
+	float Stamina = 0.f;
+};
+
+/**
+ * An ability granted to every character of an archetype. The class is resolved once when the archetype is built.
+ */
+USTRUCT(BlueprintType)
+struct FINEPLAY_API FFineAbilityArchetypeData
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "FineActorArchetype")
+	TSubclassOf<UGameplayAbility> AbilityClass;
+	UPROPERTY(BlueprintReadOnly, Category = "FineActorArchetype")
+	int32 Level = 1;
+	UPROPERTY(BlueprintReadOnly, Category = "FineActorArchetype")
+	int32 InputID = INDEX_NONE;
+};
+
+/**
+ * Immutable data shared by all actors with the same actor name. Archetypes are built by UFineActorArchetypeSubsystem
+ * from the local database, so spawning many identical actors does not query the database nor copy the records.
+ */
+UCLASS(BlueprintType)
+class FINEPLAY_API UFineActorArchetype : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	FORCEINLINE const FName& GetActorName() const { return ActorName; }
+	FORCEINLINE const FFineDisplayData& GetDisplayData() const { return DisplayData; }
+
+	/// True if character data (attributes and abilities) has been loaded into this archetype.
+	FORCEINLINE bool HasCharacterData() const { return bHasCharacterData; }
+	/// True if "CharacterAttributeSet" entity had a record for this archetype.
+	FORCEINLINE bool HasAttributeData() const { return bHasAttributeData; }
+	FORCEINLINE const FFineCharacterAttributeData& GetAttributeData() const { return AttributeData; }
+	FORCEINLINE const TArray<FFineAbilityArchetypeData>& GetAbilities() const { return Abilities; }
+
+private:
+	friend class UFineActorArchetypeSubsystem;
+
+	void LoadDisplayData(UFineLocalDatabaseComponent* Database);
+	void LoadCharacterData(UFineLocalDatabaseComponent* Database);
+
+	UPROPERTY(BlueprintReadOnly, Category = "FineActorArchetype", meta = (AllowPrivateAccess = "true"))
+	FName ActorName;
+
+	UPROPERTY(BlueprintReadOnly, Category = "FineActorArchetype", meta = (AllowPrivateAccess = "true"))
+	FFineDisplayData DisplayData;
+
+	UPROPERTY(BlueprintReadOnly, Category = "FineActorArchetype", meta = (AllowPrivateAccess = "true"))
+	FFineCharacterAttributeData AttributeData;
+
+	UPROPERTY(BlueprintReadOnly, Category = "FineActorArchetype", meta = (AllowPrivateAccess = "true"))
+	TArray<FFineAbilityArchetypeData> Abilities;
+
+	bool bHasAttributeData = false;
+	bool bHasCharacterData = false;
+};
+
+/**
+ * Keeps one archetype per actor name for the lifetime of the world.
+ */
+UCLASS()
+class FINEPLAY_API UFineActorArchetypeSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/// Returns the shared archetype for the actor name, building it from the database on first use.
+	/// Character data is loaded lazily, the first time it is requested for the archetype.
+	UFineActorArchetype* FindOrLoadArchetype(const FName& ActorName, UFineLocalDatabaseComponent* Database,
+	                                         bool bIncludeCharacterData);
+
+	/// Drops all archetypes. Actors already holding an archetype keep using it.
+	UFUNCTION(BlueprintCallable, Category = "FinePlay")
+	void ResetArchetypes();
+
+	static UFineActorArchetypeSubsystem* Get(const UObject* WorldContextObject);
+
+protected:
+	virtual void Deinitialize() override;
+
+private:
+	UPROPERTY()
+	TMap<FName, TObjectPtr<UFineActorArchetype>> Archetypes;
+};
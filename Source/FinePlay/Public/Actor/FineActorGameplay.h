@@ -10,6 +10,7 @@
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnHealthUpdated, AActor*, Actor, int32, NewHealth, int32, OldHealth);
 
+class UFineActorArchetype;
 class UFineLocalDatabaseComponent;
 /**
  * Basic gameplay for common actors
@@ -20,7 +21,11 @@ class FINEPLAY_API UFineActorGameplay : public UActorComponent
 	GENERATED_BODY()
 
 public:
-	FORCEINLINE const FFineDisplayData& GetDisplayData() const { return DisplayData; }
+	/// Display data shared by all actors with the same actor name.
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "FineActorGameplay")
+	const FFineDisplayData& GetDisplayData() const;
+
+	FORCEINLINE const UFineActorArchetype* GetArchetype() const { return Archetype; }
 
 protected:
 	virtual void BeginPlay() override;
@@ -28,12 +33,21 @@ protected:
 
 	FORCEINLINE UFineLocalDatabaseComponent* GetLocalDatabaseComponent() const { return LocalDatabaseComponent; }
 
+	/// Characters need attributes and abilities in their archetype, while plain actors only need display data.
+	virtual bool NeedsCharacterArchetype() const { return false; }
+
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineActorGameplay")
 	FName ActorName;
 
 private:
 
 	UPROPERTY(BlueprintReadOnly, Category = "FineActorGameplay", meta = (AllowPrivateAccess = "true"))
+	TObjectPtr<UFineActorArchetype> Archetype;
+
+	/// Only keeps Blueprints that read DisplayData compiling. Reads go to the archetype, this copy stays empty.
+	UPROPERTY(BlueprintGetter = GetDisplayData, Transient, Category = "FineActorGameplay", meta = (
+		AllowPrivateAccess = "true", DeprecatedProperty,
+		DeprecationMessage = "Use GetDisplayData, which reads the display data shared through the archetype."))
 	FFineDisplayData DisplayData;
 
 	UPROPERTY()
@@ -5,6 +5,8 @@
 #include "UObject/Object.h"
 #include "FineBaseAbility.generated.h"
 
+class UFineCharacterGameplay;
+
 UCLASS(Blueprintable, BlueprintType)
 class FINEPLAY_API UFineBaseAbility : public UGameplayAbility
 {
@@ -25,8 +27,49 @@ protected:
 	virtual void EndAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo,
 	                        const FGameplayAbilityActivationInfo ActivationInfo, bool bReplicateEndAbility,
 	                        bool bWasCancelled) override;
+	virtual void OnAvatarSet(const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilitySpec& Spec) override;
 	
 	TArray<FActiveGameplayEffectHandle> EffectHandles;
 
+	/// Effects applied to the owner while the ability is active. Called once per ability instance.
 	virtual TArray<TSubclassOf<UGameplayEffect>> GetEffectClasses();
+	const TArray<TSubclassOf<UGameplayEffect>>& GetCachedEffectClasses();
+
+	/// Instanced abilities build the spec once per effect class and level, and only recapture source tags and
+	/// attributes on later activations. The cache is cleared when the avatar changes.
+	FGameplayEffectSpecHandle GetOutgoingEffectSpec(const FGameplayAbilitySpecHandle Handle,
+	                                                const FGameplayAbilityActorInfo* ActorInfo,
+	                                                const FGameplayAbilityActivationInfo ActivationInfo,
+	                                                TSubclassOf<UGameplayEffect> EffectClass, float Level);
+	void ClearEffectSpecCache();
+
+private:
+	/// Stamina per second drained while active, when the character regenerates batched or continuously.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineBaseAbility|Drain",
+		meta = (AllowPrivateAccess = "true"))
+	float StaminaDrainRate = 0.f;
+
+	/// Mana per second drained while active, when the character regenerates batched or continuously.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineBaseAbility|Drain",
+		meta = (AllowPrivateAccess = "true"))
+	float ManaDrainRate = 0.f;
+
+	/// Periodic drain effects among the effect classes, skipped while the drain rates above apply instead.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineBaseAbility|Drain",
+		meta = (AllowPrivateAccess = "true"))
+	TArray<TSubclassOf<UGameplayEffect>> DrainEffectClasses;
+
+	/// Character the drain rates were added to by the current activation.
+	TWeakObjectPtr<UFineCharacterGameplay> DrainedCharacterGameplay;
+
+	struct FCachedEffectSpec
+	{
+		TSubclassOf<UGameplayEffect> EffectClass;
+		float Level = 0.f;
+		FGameplayEffectSpecHandle SpecHandle;
+	};
+
+	TArray<TSubclassOf<UGameplayEffect>> CachedEffectClasses;
+	bool bEffectClassesCached = false;
+	TArray<FCachedEffectSpec> CachedEffectSpecs;
 };
\ No newline at end of file
@@ -6,14 +6,49 @@
 #include "AttributeSet.h"
 #include "UObject/Object.h"
 #include "AbilitySystemComponent.h"
+#include "TimerManager.h"
 #include "FineCharacterAttributeSet.generated.h"
 
+class UFineCharacterGameplay;
+
 #define ATTRIBUTE_ACCESSORS(ClassName, PropertyName) \
 	GAMEPLAYATTRIBUTE_PROPERTY_GETTER(ClassName, PropertyName) \
  	GAMEPLAYATTRIBUTE_VALUE_GETTER(PropertyName) \
  	GAMEPLAYATTRIBUTE_VALUE_SETTER(PropertyName) \
  	GAMEPLAYATTRIBUTE_VALUE_INITTER(PropertyName)
 
+/**
+ * Resource changing at a constant rate. The current value is computed on read instead of being updated every frame.
+ */
+struct FINEPLAY_API FFineContinuousResource
+{
+	/// Value at Timestamp.
+	float Value = 0.f;
+	/// Change per second.
+	float Rate = 0.f;
+	/// World time in seconds.
+	double Timestamp = 0.0;
+
+	FORCEINLINE float Evaluate(double Now, float MaxValue) const
+	{
+		return FMath::Clamp(static_cast<float>(Value + Rate * (Now - Timestamp)), 0.f, MaxValue);
+	}
+
+	/// Seconds after Timestamp until the value becomes empty or full. Negative if it never does.
+	FORCEINLINE double GetTimeToBound(float MaxValue) const
+	{
+		if (Rate > 0.f && Value < MaxValue)
+		{
+			return (MaxValue - Value) / Rate;
+		}
+		if (Rate < 0.f && Value > 0.f)
+		{
+			return Value / -Rate;
+		}
+		return -1.0;
+	}
+};
+
 /**
  * Provides a common set of attributes that can be useful for any games.
  *
@@ -62,10 +97,76 @@ public:
 	UPROPERTY(BlueprintReadOnly, Category = "AttributeSet")
 	FGameplayAttributeData IncomingDamage;
 
+	UFineCharacterAttributeSet();
+
+	/// Overrides the tags used for invincibility and exhaustion. Defaults to FinePlay's native tags.
+	FORCEINLINE void SetStateTags(const FGameplayTag& InInvincibleTag, const FGameplayTag& InExhaustedTag)
+	{
+		InvincibleTag = InInvincibleTag;
+		ExhaustedTag = InExhaustedTag;
+	}
+
+	/// Character whose state flags answer invincibility checks. Null checks the invincible tag instead.
+	FORCEINLINE void SetCharacterGameplay(UFineCharacterGameplay* InCharacterGameplay)
+	{
+		CharacterGameplay = InCharacterGameplay;
+	}
+
+	/// Incoming damage is handed to the aggregator instead of being applied right away. Null applies it directly.
+	FORCEINLINE void SetDamageAggregator(UFineCharacterGameplay* InDamageAggregator)
+	{
+		DamageAggregator = InDamageAggregator;
+	}
+
+	/// Makes stamina or mana change continuously by the rate per second. The attribute is written only when a gameplay
+	/// effect modifies it and when it becomes empty or full, so use GetCurrentStamina and GetCurrentMana to read it.
+	void SetContinuousRate(const FGameplayAttribute& Attribute, float Rate);
+	/// Writes the current value to the attribute and stops changing it.
+	void StopContinuous(const FGameplayAttribute& Attribute);
+	bool IsContinuous(const FGameplayAttribute& Attribute) const;
+
+	/// Stamina including continuous change since the attribute was last written.
+	FORCEINLINE float GetCurrentStamina() const { return GetCurrentValue(ContinuousStamina); }
+	/// Mana including continuous change since the attribute was last written.
+	FORCEINLINE float GetCurrentMana() const { return GetCurrentValue(ContinuousMana); }
+
 protected:
 	virtual bool PreGameplayEffectExecute(struct FGameplayEffectModCallbackData& Data) override;
 	virtual void PostGameplayEffectExecute(const struct FGameplayEffectModCallbackData& Data) override;
 
 	virtual void PreAttributeChange(const FGameplayAttribute& Attribute, float& NewValue) override;
 	virtual void PostAttributeChange(const FGameplayAttribute& Attribute, float OldValue, float NewValue) override;
+
+private:
+	enum EContinuousResource : int32
+	{
+		ContinuousStamina,
+		ContinuousMana,
+		ContinuousResourceCount
+	};
+
+	static int32 GetContinuousIndex(const FGameplayAttribute& Attribute);
+	static FGameplayAttribute GetContinuousAttribute(int32 Index);
+	float GetContinuousMaxValue(int32 Index) const;
+	float GetCurrentValue(int32 Index) const;
+	double GetWorldTime() const;
+
+	/// Writes the evaluated value to the attribute, which rebases the resource.
+	void SettleContinuous(int32 Index);
+	void RebaseContinuous(int32 Index, float Value);
+	/// Schedules the only callback needed, when the resource becomes empty or full.
+	void ScheduleContinuous(int32 Index);
+	void OnContinuousBoundReached(int32 Index);
+	/// Adds the exhausted tag while stamina isn't full or drains continuously, removes it otherwise.
+	void UpdateExhaustedTag(float Stamina);
+
+	FGameplayTag InvincibleTag;
+	FGameplayTag ExhaustedTag;
+
+	TWeakObjectPtr<UFineCharacterGameplay> CharacterGameplay;
+	TWeakObjectPtr<UFineCharacterGameplay> DamageAggregator;
+
+	FFineContinuousResource ContinuousResources[ContinuousResourceCount];
+	bool bContinuous[ContinuousResourceCount] = {};
+	FTimerHandle ContinuousTimers[ContinuousResourceCount];
 };
@@ -3,18 +3,60 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "FineAbilityCancellationRules.h"
+#include "FineAbilityRegistry.h"
 #include "FineActorGameplay.h"
+#include "FineCharacterSnapshot.h"
+#include "FineGroundProbe.h"
+#include "FineResourceRegenSubsystem.h"
 #include "GameplayEffectTypes.h"
 #include "UObject/Object.h"
+#include <atomic>
 #include "FineCharacterGameplay.generated.h"
 
-struct FGameplayAbilitySpecHandle;
 class UFineCharacterAttributeSet;
+class UFineMovementStateSubsystem;
 class UAbilitySystemComponent;
+class UCapsuleComponent;
+class UCharacterMovementComponent;
+class UGameplayEffect;
 
 // The actual damage done to the character after all calculations are done.
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnCharacterDamageTaken, float, Damage);
 
+/// Damage a character took within one frame when damage is aggregated.
+USTRUCT(BlueprintType)
+struct FINEPLAY_API FFineDamageSummary
+{
+	GENERATED_BODY()
+
+	/// Sum of incoming damage, before health is clamped.
+	UPROPERTY(BlueprintReadOnly, Category = "FineDamageSummary")
+	float TotalDamage = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineDamageSummary")
+	int32 HitCount = 0;
+	/// Distinct effect causers, or instigators if there was no causer.
+	UPROPERTY(BlueprintReadOnly, Category = "FineDamageSummary")
+	TArray<TObjectPtr<AActor>> Sources;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnCharacterDamageSummarized, const FFineDamageSummary&, Summary);
+
+/// Character states mirrored from the ability system's gameplay tags.
+UENUM(BlueprintType, meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class EFineCharacterState : uint8
+{
+	None = 0 UMETA(Hidden),
+	Alive = 1 << 0,
+	Invincible = 1 << 1,
+	Moving = 1 << 2,
+	Running = 1 << 3,
+	Jumping = 1 << 4,
+	Exhausted = 1 << 5,
+};
+
+ENUM_CLASS_FLAGS(EFineCharacterState);
+
 /**
  * Provides functionalities for managing character gameplay.
  */
@@ -32,18 +74,77 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure)
 	bool IsInvincible();
 
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "FineCharacterGameplay")
+	bool HasCharacterState(EFineCharacterState State) const { return HasState(State); }
+
+	/// Single bit test against the state flags. Safe to call from any thread.
+	FORCEINLINE bool HasState(const EFineCharacterState State) const
+	{
+		return (StateFlags.load(std::memory_order_relaxed) & static_cast<uint8>(State)) != 0;
+	}
+
+	FORCEINLINE EFineCharacterState GetStateFlags() const
+	{
+		return static_cast<EFineCharacterState>(StateFlags.load(std::memory_order_relaxed));
+	}
+
+	/// Returns the character gameplay component of the actor, using the cached one of FinePlay characters.
+	static UFineCharacterGameplay* FindCharacterGameplay(const AActor* Actor);
+
+	/// Attributes and state flags as of the last published frame. Safe to call from any thread.
+	FORCEINLINE FFineCharacterSnapshot GetSnapshot() const { return SnapshotBuffer.Read(); }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "FineCharacterGameplay")
+	FFineCharacterSnapshot GetCharacterSnapshot() const { return GetSnapshot(); }
+
 	UFUNCTION(BlueprintCallable, CallInEditor, Category = "FineCharacterGameplay")
 	FGameplayAbilitySpecHandle AddAbilityByClass(UClass* InClass, int32 InLevel, int32 InInputID,
 	                                             UObject* InSourceObject = nullptr);
 	UFUNCTION(BlueprintCallable, CallInEditor, Category = "FineCharacterGameplay")
 	void RemoveAbilityByClass(UClass* InClass);
 
+	/// Grants all abilities while the ability list is locked, so the ability system applies them in one batch.
+	UFUNCTION(BlueprintCallable, Category = "FineCharacterGameplay")
+	void GrantAbilities(const TArray<FFineAbilityGrant>& Grants, TArray<FGameplayAbilitySpecHandle>& OutHandles);
+	/// Revokes the given abilities in one batch. Handles not granted by this component are ignored.
+	UFUNCTION(BlueprintCallable, Category = "FineCharacterGameplay")
+	void RevokeAbilities(const TArray<FGameplayAbilitySpecHandle>& Handles);
+	UFUNCTION(BlueprintCallable, Category = "FineCharacterGameplay")
+	void RevokeAbilitiesBySourceObject(UObject* InSourceObject);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "FineCharacterGameplay")
+	FGameplayAbilitySpecHandle FindAbilityHandleByClass(UClass* InClass) const;
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "FineCharacterGameplay")
+	FGameplayAbilitySpecHandle FindAbilityHandleByInputID(int32 InInputID) const;
+
+	FORCEINLINE const FFineAbilityRegistry& GetAbilityRegistry() const { return AbilityRegistry; }
+
+	/// Returns the ID to remove the rule with.
+	UFUNCTION(BlueprintCallable, Category = "FineCharacterGameplay")
+	int32 AddAbilityCancellationRule(const FFineAbilityCancellationRule& Rule);
+	UFUNCTION(BlueprintCallable, Category = "FineCharacterGameplay")
+	void RemoveAbilityCancellationRule(int32 RuleID);
+
 	UPROPERTY(BlueprintAssignable)
 	FOnCharacterDamageTaken OnCharacterDamageTaken;
+	/// Broadcast once per frame with all damage taken in it, when damage is aggregated.
+	UPROPERTY(BlueprintAssignable)
+	FOnCharacterDamageSummarized OnCharacterDamageSummarized;
+
+	/// Adds a hit to this frame's damage. Lethal damage is applied right away so death is detected on the killing hit.
+	void AccumulateDamage(float Damage, AActor* Source);
+	/// Applies the damage accumulated so far in one health update.
+	void FlushDamage();
 
+	/// Answered from the ground probe for horizontal offsets within GroundProbeRadius, traced directly otherwise.
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "FineCharacterGameplay")
 	float GetDistanceFromGroundStaticMesh(const FVector Offset = FVector::ZeroVector);
 
+	/// Ground at a horizontal offset, interpolated from this frame's probe samples. False outside GroundProbeRadius
+	/// or if the offset has a vertical part.
+	UFUNCTION(BlueprintCallable, Category = "FineCharacterGameplay")
+	bool GetGroundSample(const FVector Offset, FFineGroundSample& OutSample);
+
 	UFUNCTION(BlueprintCallable, Category = "FineCharacterGameplay")
 	FVector GetFeetLocation() const;
 
@@ -63,12 +164,28 @@ public:
 	FName JumpGameplayTagName;
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCharacterGameplay", meta = (AllowPrivateAccess = "true"))
 	FName RunGameplayTagName;
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCharacterGameplay", meta = (AllowPrivateAccess = "true"))
+	FName MovingGameplayTagName;
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCharacterGameplay", meta = (AllowPrivateAccess = "true"))
+	FName ExhaustedGameplayTagName;
+
+	// Tags resolved from the tag names above at BeginPlay.
+	FORCEINLINE const FGameplayTag& GetAliveTag() const { return AliveTag; }
+	FORCEINLINE const FGameplayTag& GetInvincibleTag() const { return InvincibleTag; }
+	FORCEINLINE const FGameplayTag& GetJumpTag() const { return JumpTag; }
+	FORCEINLINE const FGameplayTag& GetRunTag() const { return RunTag; }
+	FORCEINLINE const FGameplayTag& GetMovingTag() const { return MovingTag; }
+	FORCEINLINE const FGameplayTag& GetExhaustedTag() const { return ExhaustedTag; }
 
 	UAbilitySystemComponent* SetAndGetAbilitySystemComponent();
 
 protected:
+	virtual void OnRegister() override;
 	virtual void BeginPlay() override;
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
+	                           FActorComponentTickFunction* ThisTickFunction) override;
+	virtual bool NeedsCharacterArchetype() const override { return true; }
 
 	FORCEINLINE void SetAttributeSetClass(const TSubclassOf<UFineCharacterAttributeSet>& InAttributeSetClass)
 	{
@@ -81,17 +198,120 @@ protected:
 	void GiveDefaultAbilities();
 	void ClearAllAbilities();
 
+	/// Resolves tag names to tags once, so that tags are never looked up by name afterwards.
+	void ResolveGameplayTags();
+
+	/// Mirrors state tags into the state flags.
+	void BindStateTagEvents(UAbilitySystemComponent* AbilitySystem);
+	void UnbindStateTagEvents(UAbilitySystemComponent* AbilitySystem);
+	void OnStateTagChanged(const FGameplayTag Tag, int32 NewCount, EFineCharacterState State);
+
+	/// Requests the snapshot to be published at the end of the frame. The component only ticks while dirty.
+	void MarkSnapshotDirty();
+	void PublishSnapshot();
+	void OnSnapshotAttributeChanged(const FOnAttributeChangeData& OnAttributeChangeData);
+
+	/// Resolves cancellation rules to spec handles and listens to the attributes they watch.
+	void CompileAbilityCancellationRules();
+	void OnCancellationAttributeChanged(const FOnAttributeChangeData& OnAttributeChangeData);
+
+	/// Queues the moving tag update with UFineMovementStateSubsystem.
+	UFUNCTION()
+	void OnCharacterMovementUpdated(float DeltaSeconds, FVector OldLocation, FVector OldVelocity);
+
+	/// Sibling components, resolved when registered and again only if they went away.
+	UCapsuleComponent* GetOwnerCapsule() const;
+	UCharacterMovementComponent* GetOwnerCharacterMovement() const;
+	void CacheOwnerComponents() const;
+
+	bool IsRegenBatched() const;
+	UFineResourceRegenSubsystem* GetRegenSubsystem() const;
+
 private:
 	UPROPERTY(meta = (AllowPrivateAccess = "true"))
 	TWeakObjectPtr<UAbilitySystemComponent> AbilitySystemComponent;
 
+	mutable TWeakObjectPtr<UCapsuleComponent> CachedCapsule;
+	mutable TWeakObjectPtr<UCharacterMovementComponent> CachedCharacterMovement;
+
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCharacterGameplay", meta = (AllowPrivateAccess = "true"))
 	TSubclassOf<UFineCharacterAttributeSet> AttributeSetClass;
 
+	/// Applies all damage taken within a frame in one health update, broadcasting OnCharacterDamageTaken once.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCharacterGameplay|Damage",
+		meta = (AllowPrivateAccess = "true"))
+	bool bAggregateDamage = false;
+
+	UPROPERTY(Transient)
+	FFineDamageSummary PendingDamage;
+
+	/// Samples on the ground probe's ring, besides the one at the actor location.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCharacterGameplay|Ground",
+		meta = (AllowPrivateAccess = "true", ClampMin = "3"))
+	int32 GroundProbeSampleCount = 4;
+	/// Covers the offsets movement input checks for ledges.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCharacterGameplay|Ground",
+		meta = (AllowPrivateAccess = "true"))
+	float GroundProbeRadius = 5.f;
+	/// Trace the ground asynchronously and answer ground queries from the previous frame's traces.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCharacterGameplay|Ground",
+		meta = (AllowPrivateAccess = "true"))
+	bool bAsyncGroundTraces = false;
+	FFineGroundProbe GroundProbe;
+
+	/// Added when play begins, e.g. to cancel abilities when a resource is depleted.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCharacterGameplay", meta = (AllowPrivateAccess = "true"))
+	TArray<FFineAbilityCancellationRule> AbilityCancellationRules;
+
+	/// Periodic effect applies StaminaRefillEffectClass, including its tag requirements. Batched regeneration is
+	/// cheaper for many characters, continuous costs nothing until a value is empty or full. Both regenerate at the
+	/// rates below instead of applying the effect.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCharacterGameplay|Regeneration",
+		meta = (AllowPrivateAccess = "true"))
+	EFineResourceRegenMode ResourceRegenMode = EFineResourceRegenMode::PeriodicEffect;
+	/// Stamina per second, for batched and continuous regeneration. Negative uses the rate of
+	/// StaminaRefillEffectClass, from its additive stamina modifiers and period.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCharacterGameplay|Regeneration",
+		meta = (AllowPrivateAccess = "true"))
+	float StaminaRegenRate = -1.f;
+	/// Mana per second, for batched and continuous regeneration.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCharacterGameplay|Regeneration",
+		meta = (AllowPrivateAccess = "true"))
+	float ManaRegenRate = 0.f;
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCharacterGameplay|Regeneration",
+		meta = (AllowPrivateAccess = "true"))
+	TSoftClassPtr<UGameplayEffect> StaminaRefillEffectClass;
+	/// Sum of AddResourceDrainRates.
+	float ActiveStaminaDrainRate = 0.f;
+	float ActiveManaDrainRate = 0.f;
+
+	/// Attribute set spawned at BeginPlay.
+	UPROPERTY(Transient)
+	TObjectPtr<UFineCharacterAttributeSet> CachedAttributeSet;
+
+	FGameplayTag AliveTag;
+	FGameplayTag InvincibleTag;
+	FGameplayTag JumpTag;
+	FGameplayTag RunTag;
+	FGameplayTag MovingTag;
+	FGameplayTag ExhaustedTag;
+
+	std::atomic<uint8> StateFlags{0};
+	TArray<TPair<FGameplayTag, FDelegateHandle>> StateTagEventHandles;
+
+	FFineCharacterSnapshotBuffer SnapshotBuffer;
+	bool bSnapshotDirty = false;
+	TArray<TPair<FGameplayAttribute, FDelegateHandle>> SnapshotAttributeHandles;
+
+	TWeakObjectPtr<UFineMovementStateSubsystem> MovementStateSubsystem;
+	int32 MovementStateSlot = INDEX_NONE;
+
 	FDelegateHandle OnHealthUpdated;
 	FDelegateHandle OnMovementSpeedUpdated;
 
-	TArray<FGameplayAbilitySpecHandle> AbilityHandles;
+	FFineAbilityRegistry AbilityRegistry;
+	FFineAbilityCancellationRules CancellationRules;
+	TArray<TPair<FGameplayAttribute, FDelegateHandle>> CancellationAttributeHandles;
 
 public:
 	// ------------------
@@ -147,5 +367,13 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void SetMaxStamina(float InMaxStamina);
 
+	/// Drain per second subtracted from regeneration, e.g. while sprinting. Ignored by periodic effect regeneration.
+	UFUNCTION(BlueprintCallable, Category = "FineCharacterGameplay|Regeneration")
+	void SetResourceDrainRates(float StaminaDrainRate, float ManaDrainRate);
+	/// Adds to the drain rates of active abilities, e.g. the rate on activation and its negation when they end.
+	void AddResourceDrainRates(float StaminaDrainDelta, float ManaDrainDelta);
+	/// True if drain rates apply, i.e. regeneration is batched or continuous instead of periodic effects.
+	bool IsResourceDrainLazy() const;
+
 	UFineCharacterAttributeSet* GetAttributeSet() const;
 };
@@ -0,0 +1,80 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+#include "FineCharacterSnapshot.generated.h"
+
+/**
+ * Plain copy of a character's attributes and state flags. Readers on any thread can use it without touching UObjects.
+ */
+USTRUCT(BlueprintType)
+struct FINEPLAY_API FFineCharacterSnapshot
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "FineCharacterSnapshot")
+	float Health = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineCharacterSnapshot")
+	float MaxHealth = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineCharacterSnapshot")
+	float Mana = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineCharacterSnapshot")
+	float MaxMana = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineCharacterSnapshot")
+	float MovementSpeed = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineCharacterSnapshot")
+	float MaxMovementSpeed = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineCharacterSnapshot")
+	float AttackPower = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineCharacterSnapshot")
+	float DefensePower = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineCharacterSnapshot")
+	float Stamina = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineCharacterSnapshot")
+	float MaxStamina = 0.f;
+	/// EFineCharacterState flags.
+	UPROPERTY(BlueprintReadOnly, Category = "FineCharacterSnapshot")
+	uint8 StateFlags = 0;
+	/// Frame the snapshot was published in.
+	uint64 FrameNumber = 0;
+};
+
+/**
+ * Double buffered snapshot. The game thread publishes, other threads read the last published copy without locking.
+ */
+class FINEPLAY_API FFineCharacterSnapshotBuffer
+{
+public:
+	/// Game thread only.
+	void Publish(const FFineCharacterSnapshot& Snapshot)
+	{
+		const auto Sequence = Published.load(std::memory_order_relaxed) + 1;
+		Started.store(Sequence, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		Buffers[Sequence & 1] = Snapshot;
+		Published.store(Sequence, std::memory_order_release);
+	}
+
+	/// Any thread.
+	FFineCharacterSnapshot Read() const
+	{
+		for (;;)
+		{
+			const auto Sequence = Published.load(std::memory_order_acquire);
+			const FFineCharacterSnapshot Result = Buffers[Sequence & 1];
+			std::atomic_thread_fence(std::memory_order_acquire);
+			// The buffer just read is written again only by the publish after next.
+			if (Started.load(std::memory_order_relaxed) < Sequence + 2)
+			{
+				return Result;
+			}
+		}
+	}
+
+private:
+	FFineCharacterSnapshot Buffers[2];
+	std::atomic<uint64> Started{0};
+	std::atomic<uint64> Published{0};
+};
@@ -0,0 +1,66 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Utilities/FineAsyncLineTrace.h"
+#include "FineGroundProbe.generated.h"
+
+class UPhysicalMaterial;
+
+/// Ground below a point around a character.
+USTRUCT(BlueprintType)
+struct FINEPLAY_API FFineGroundSample
+{
+	GENERATED_BODY()
+
+	/// Horizontal offset from the actor location.
+	UPROPERTY(BlueprintReadOnly, Category = "FineGroundSample")
+	FVector Offset = FVector::ZeroVector;
+	/// Distance from the bottom of the capsule to the ground, or the probe's max distance if nothing was hit.
+	UPROPERTY(BlueprintReadOnly, Category = "FineGroundSample")
+	float Distance = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "FineGroundSample")
+	FVector Normal = FVector::UpVector;
+	UPROPERTY(BlueprintReadOnly, Category = "FineGroundSample")
+	TWeakObjectPtr<UPhysicalMaterial> Surface;
+	UPROPERTY(BlueprintReadOnly, Category = "FineGroundSample")
+	bool bHit = false;
+};
+
+/**
+ * Samples the ground below a character once per frame, at its location and on a ring around it, and answers ground
+ * queries from those samples. The number of traces per frame is fixed however often the ground is queried.
+ */
+class FINEPLAY_API FFineGroundProbe
+{
+public:
+	/// RingSampleCount samples are spread evenly on a circle of Radius around the actor location.
+	void Configure(int32 RingSampleCount, float InRadius, float InMaxDistance, bool bInAsync);
+
+	/// Traces unless the samples were already taken this frame at the same location.
+	void Update(const AActor* Owner, float CapsuleHalfHeight);
+
+	/// Interpolates the samples at the given horizontal offset. False if the offset is outside the ring or has a
+	/// vertical part, which would move the trace start.
+	bool GetSample(const FVector& Offset, FFineGroundSample& OutSample) const;
+
+	/// The sample at the actor location first, then ring samples counterclockwise from +X.
+	FORCEINLINE const TArray<FFineGroundSample>& GetSamples() const { return Samples; }
+	FORCEINLINE float GetMaxDistance() const { return MaxDistance; }
+
+	void Reset();
+
+private:
+	void Trace(UWorld* World, const AActor* Owner, int32 Index, float CapsuleHalfHeight);
+
+	TArray<FFineGroundSample> Samples;
+	/// Parallel to Samples, used when async.
+	TArray<FFineAsyncLineTrace> AsyncTraces;
+	float Radius = 5.f;
+	float MaxDistance = 1000.f;
+	bool bAsync = false;
+
+	uint64 SampledFrame = 0;
+	FVector SampledLocation = FVector::ZeroVector;
+};
@@ -0,0 +1,65 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FineMovementStateSubsystem.generated.h"
+
+class UAbilitySystemComponent;
+class UCharacterMovementComponent;
+
+/**
+ * Keeps the moving tag of every registered character, player or AI, in sync with its velocity.
+ *
+ * Characters are queued when their movement component updates and evaluated together once per frame, after movement.
+ * Speed is compared squared against separate start and stop thresholds, and the tag changes only on transitions.
+ */
+UCLASS()
+class FINEPLAY_API UFineMovementStateSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/// Returns the slot to pass to MarkMovementUpdated and Unregister.
+	int32 Register(UCharacterMovementComponent* Movement, UAbilitySystemComponent* AbilitySystem,
+	               const FGameplayTag& MovingTag, bool bMoving);
+	/// Removes the moving tag if it was set.
+	void Unregister(int32 Slot);
+
+	/// Queues the character for the next pass. Called for each movement update, so it's cheap to call repeatedly.
+	FORCEINLINE void MarkMovementUpdated(const int32 Slot)
+	{
+		if (Queued.IsValidIndex(Slot) && !Queued[Slot])
+		{
+			Queued[Slot] = true;
+			Queue.Add(Slot);
+		}
+	}
+
+	FORCEINLINE bool IsMoving(const int32 Slot) const { return Moving.IsValidIndex(Slot) && Moving[Slot]; }
+
+	static UFineMovementStateSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual void Deinitialize() override;
+
+private:
+	void SetMoving(int32 Slot, bool bMoving);
+
+	// Slots are stable while registered, freed slots are reused.
+	TArray<TWeakObjectPtr<UCharacterMovementComponent>> Movements;
+	TArray<TWeakObjectPtr<UAbilitySystemComponent>> AbilitySystems;
+	TArray<FGameplayTag> MovingTags;
+	TArray<bool> Moving;
+	TArray<bool> Queued;
+	TArray<int32> FreeSlots;
+
+	/// Slots whose movement updated since the last pass.
+	TArray<int32> Queue;
+	TArray<int32> Processing;
+};
@@ -28,11 +28,18 @@ public:
 		return AbilitySystemComponent;
 	}
 
+	/// Character gameplay component found once the components are initialized.
+	FORCEINLINE UFineCharacterGameplay* GetCharacterGameplay() const { return CharacterGameplay.Get(); }
+
 protected:
+	virtual void PostInitializeComponents() override;
 	virtual void BeginPlay() override;
 
 private:
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "FinePaperCharacter", meta = (AllowPrivateAccess = "true"))
 	UAbilitySystemComponent* AbilitySystemComponent;
 
+	UPROPERTY(Transient)
+	TWeakObjectPtr<UFineCharacterGameplay> CharacterGameplay;
+
 };
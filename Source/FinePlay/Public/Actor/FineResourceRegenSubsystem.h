@@ -0,0 +1,93 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "FineResourceRegenSubsystem.generated.h"
+
+class UFineCharacterAttributeSet;
+
+/// How a character regenerates stamina and mana.
+UENUM(BlueprintType)
+enum class EFineResourceRegenMode : uint8
+{
+	/// Simulated together with all other characters by UFineResourceRegenSubsystem.
+	Batched,
+	/// Periodic gameplay effect applied to each character.
+	PeriodicEffect,
+	/// Evaluated on read by the attribute set, which wakes up only when a value becomes empty or full.
+	Continuous,
+};
+
+/**
+ * Regenerates stamina and mana of all registered characters in one pass per frame (or per fixed step).
+ *
+ * Values are kept in structure-of-arrays form and advanced in parallel. They are written back to the attribute sets
+ * only when a value reaches empty or full, or once every write back interval, so the attribute set doesn't change
+ * every frame. Use GetStamina and GetMana to read up to date values in between.
+ */
+UCLASS()
+class FINEPLAY_API UFineResourceRegenSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void Register(UFineCharacterAttributeSet* AttributeSet, float StaminaRegenRate, float ManaRegenRate);
+	void Unregister(UFineCharacterAttributeSet* AttributeSet);
+	FORCEINLINE bool IsRegistered(const UFineCharacterAttributeSet* AttributeSet) const
+	{
+		return Indices.Contains(FObjectKey(AttributeSet));
+	}
+
+	/// Drain is subtracted from regeneration, e.g. while sprinting.
+	void SetDrainRates(const UFineCharacterAttributeSet* AttributeSet, float StaminaDrainRate, float ManaDrainRate);
+
+	/// Pulls values from the attribute set after they were changed by anything else than this subsystem.
+	void SyncFromAttributeSet(const UFineCharacterAttributeSet* AttributeSet);
+
+	/// Writes simulated values to the attribute set now.
+	void WriteBack(const UFineCharacterAttributeSet* AttributeSet);
+
+	bool GetStamina(const UFineCharacterAttributeSet* AttributeSet, float& OutStamina) const;
+	bool GetMana(const UFineCharacterAttributeSet* AttributeSet, float& OutMana) const;
+
+	/// True while this subsystem is updating an attribute set.
+	FORCEINLINE bool IsWritingBack() const { return bWritingBack; }
+
+	static UFineResourceRegenSubsystem* Get(const UObject* WorldContextObject);
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual void Deinitialize() override;
+
+private:
+	void WriteBackAt(int32 Index);
+	void RemoveAt(int32 Index);
+
+	TMap<FObjectKey, int32> Indices;
+	TArray<FObjectKey> Keys;
+	TArray<TWeakObjectPtr<UFineCharacterAttributeSet>> AttributeSets;
+
+	TArray<float> Stamina;
+	TArray<float> MaxStamina;
+	TArray<float> StaminaRegenRate;
+	TArray<float> StaminaDrainRate;
+	TArray<float> WrittenStamina;
+
+	TArray<float> Mana;
+	TArray<float> MaxMana;
+	TArray<float> ManaRegenRate;
+	TArray<float> ManaDrainRate;
+	TArray<float> WrittenMana;
+
+	/// Set by the parallel pass when a value crossed empty or full.
+	TArray<bool> CrossedThreshold;
+
+	float StepAccumulator = 0.f;
+	float WriteBackElapsed = 0.f;
+	bool bWritingBack = false;
+};
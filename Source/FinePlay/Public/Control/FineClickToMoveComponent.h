@@ -0,0 +1,88 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AITypes.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "Components/ActorComponent.h"
+#include "NavigationData.h"
+#include "FineClickToMoveComponent.generated.h"
+
+class UPathFollowingComponent;
+struct FPathFollowingResult;
+
+/**
+ * Moves the possessed pawn of a controller to clicked destinations without pathfinding on the game thread.
+ *
+ * Paths are found asynchronously. Requests arriving faster than MinRequestInterval or while a query is running are
+ * coalesced into the latest destination. A destination near the previous one reuses the previous path's corridor and
+ * only replaces its end, if the navmesh between them is clear.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class FINEPLAY_API UFineClickToMoveComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UFineClickToMoveComponent();
+
+	UFUNCTION(BlueprintCallable, Category = "FineClickToMove")
+	void RequestMoveTo(const FVector& Destination);
+
+	/// Drops the running query and queued destination. Doesn't stop the current movement.
+	UFUNCTION(BlueprintCallable, Category = "FineClickToMove")
+	void CancelPendingRequests();
+
+	/// Drops pending requests and the current path. Call when the pawn's movement was stopped.
+	UFUNCTION(BlueprintCallable, Category = "FineClickToMove")
+	void StopMovement();
+
+	FORCEINLINE bool IsQueryPending() const { return PendingQueryID != INVALID_NAVQUERYID; }
+
+	static UFineClickToMoveComponent* Get(const AController* Controller);
+
+	/// The path from the pawn along the corridor of the given path, with its end moved to the destination. Null if
+	/// the pawn is further than MaxDeviation from the path. Doesn't check the navmesh.
+	static FNavPathSharedPtr MakeRepairedPath(const FNavigationPath& Path, const FVector& PawnLocation,
+	                                          const FVector& Destination, float MaxDeviation);
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/// Follows the previous path with only its end moved. False if the previous path can't be reused.
+	bool TryRepairPath(const FVector& Destination);
+	void IssueQueuedRequest();
+	void OnPathFound(uint32 QueryID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+	void FollowPath(const FNavPathSharedPtr& Path, const FVector& Destination);
+	void OnMoveFinished(FAIRequestID RequestID, const FPathFollowingResult& Result);
+	UPathFollowingComponent* GetPathFollowing();
+
+private:
+	/// Minimum seconds between path queries. Destinations in between are coalesced.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineClickToMove", meta = (AllowPrivateAccess = "true"))
+	float MinRequestInterval = 0.1f;
+
+	/// A destination within this distance of the previous one reuses the previous path.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineClickToMove", meta = (AllowPrivateAccess = "true"))
+	float RepairRadius = 200.f;
+
+	/// The previous path is only reused while the pawn is within this distance of it.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineClickToMove", meta = (AllowPrivateAccess = "true"))
+	float RepairMaxDeviation = 50.f;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UPathFollowingComponent> PathFollowing;
+
+	uint32 PendingQueryID = INVALID_NAVQUERYID;
+	FVector PendingQueryDestination = FVector::ZeroVector;
+
+	bool bHasQueuedDestination = false;
+	FVector QueuedDestination = FVector::ZeroVector;
+	double LastRequestTime = -UE_BIG_NUMBER;
+	FTimerHandle ThrottleTimerHandle;
+
+	/// Path being followed, cleared once the movement finished or was stopped.
+	FNavPathSharedPtr CurrentPath;
+	FVector CurrentDestination = FVector::ZeroVector;
+};
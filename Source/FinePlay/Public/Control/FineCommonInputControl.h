@@ -4,7 +4,9 @@
 #include "UObject/Object.h"
 #include "FineCommonInputControl.generated.h"
 
+enum class EFineInputEvent : uint8;
 class UAbilitySystemComponent;
+class UCharacterMovementComponent;
 class UFineCharacterGameplay;
 class UInputAction;
 struct FInputBindingHandle;
@@ -24,6 +26,9 @@ public:
 		InteractActionInputID = InInteractActionID;
 	}
 
+	/// Calls the handler of a recorded input event, see FineInputReplay.
+	virtual void ReplayInputEvent(EFineInputEvent Event, const FVector3f& Value);
+
 protected:
 	virtual void SetupInputComponent();
 	virtual void TearDownInputComponent();
@@ -38,6 +43,11 @@ protected:
 
 	UFineCharacterGameplay* GetCharacterGameplay() const;
 	bool GetAbilitySystemComponent(UAbilitySystemComponent*& OutAbilitySystemComponent) const;
+	UCharacterMovementComponent* GetCharacterMovement() const;
+
+	/// Resolves the components of the possessed pawn. They are also resolved on first use after the pawn changed.
+	void CachePawnComponents() const;
+	void ClearPawnComponents();
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input, meta=(AllowPrivateAccess = "true"))
 	UInputMappingContext* DefaultMappingContext;
@@ -45,6 +55,12 @@ protected:
 	TArray<FInputBindingHandle> ActionBindings;
 	
 private:
+	// Components of CachedPawn, so that input events don't search components.
+	mutable TWeakObjectPtr<APawn> CachedPawn;
+	mutable TWeakObjectPtr<UFineCharacterGameplay> CachedCharacterGameplay;
+	mutable TWeakObjectPtr<UAbilitySystemComponent> CachedAbilitySystem;
+	mutable TWeakObjectPtr<UCharacterMovementComponent> CachedCharacterMovement;
+
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input, meta=(AllowPrivateAccess = "true"))
 	UInputAction* InteractAction;
 
@@ -0,0 +1,77 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "FineCursorEffectComponent.generated.h"
+
+class UNiagaraComponent;
+class UNiagaraSystem;
+
+/**
+ * Pool of Niagara components for effects spawned at clicked locations.
+ *
+ * Components are created once, by Prewarm or on first use, and are reused when their effect completed or their
+ * lifetime ran out. A spawn shortly after the previous one moves the still playing effect instead of taking another
+ * component, and restarts it at most once every MinRestartInterval.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class FINEPLAY_API UFineCursorEffectComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UFineCursorEffectComponent();
+
+	/// Creates the pooled components for the system up front.
+	UFUNCTION(BlueprintCallable, Category = "FineCursorEffect")
+	void Prewarm(UNiagaraSystem* System);
+
+	/// Plays the system at the location. Returns the component playing it.
+	UFUNCTION(BlueprintCallable, Category = "FineCursorEffect")
+	UNiagaraComponent* SpawnEffect(UNiagaraSystem* System, const FVector& Location);
+
+	/// Stops all effects and returns their components to the pool.
+	UFUNCTION(BlueprintCallable, Category = "FineCursorEffect")
+	void ReleaseAll();
+
+	static UFineCursorEffectComponent* Get(const AController* Controller);
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UNiagaraComponent* CreatePooledComponent(UNiagaraSystem* System);
+	/// Free component, or the one that played longest if all are busy.
+	int32 AcquireSlot(UNiagaraSystem* System);
+	void ReleaseExpired();
+	void ScheduleRelease();
+
+private:
+	/// Number of pooled components. Effects still playing when all are busy are cut short.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCursorEffect", meta = (AllowPrivateAccess = "true",
+		ClampMin = "1"))
+	int32 PoolSize = 3;
+
+	/// Seconds after which a playing effect is stopped and its component returned to the pool.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCursorEffect", meta = (AllowPrivateAccess = "true"))
+	float Lifetime = 2.f;
+
+	/// A spawn within this many seconds of the previous one moves the previous effect instead.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCursorEffect", meta = (AllowPrivateAccess = "true"))
+	float RetargetWindow = 0.5f;
+
+	/// A retargeted effect restarts at most this often, otherwise it is only moved.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCursorEffect", meta = (AllowPrivateAccess = "true"))
+	float MinRestartInterval = 0.1f;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UNiagaraComponent>> Pool;
+
+	/// World time each pooled component was last started, parallel to Pool.
+	TArray<double> StartTimes;
+
+	int32 LastSlot = INDEX_NONE;
+	double LastSpawnTime = -UE_BIG_NUMBER;
+	FTimerHandle ReleaseTimerHandle;
+};
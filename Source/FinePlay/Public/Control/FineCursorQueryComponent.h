@@ -0,0 +1,92 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Engine/HitResult.h"
+#include "InputCoreTypes.h"
+#include "Utilities/FineAsyncLineTrace.h"
+#include "FineCursorQueryComponent.generated.h"
+
+/**
+ * Shared cursor and finger queries of a player controller.
+ *
+ * Traces under the cursor or a finger at most once per frame per channel and deprojects at most once per frame, then
+ * serves the cached result to every caller in the same frame, e.g. click to move and hover highlighting.
+ *
+ * With bAsyncTraces, traces run off the game thread and are served one frame late.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class FINEPLAY_API UFineCursorQueryComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UFineCursorQueryComponent();
+
+	/// Hit under the mouse cursor on TraceChannel.
+	UFUNCTION(BlueprintCallable, Category = "FineCursorQuery")
+	bool GetHitResultUnderCursor(FHitResult& OutHit);
+	bool GetHitResultUnderCursorByChannel(ECollisionChannel Channel, FHitResult& OutHit);
+
+	/// Hit under the finger on TraceChannel. False while the finger isn't pressed.
+	UFUNCTION(BlueprintCallable, Category = "FineCursorQuery")
+	bool GetHitResultUnderFinger(ETouchIndex::Type FingerIndex, FHitResult& OutHit);
+	bool GetHitResultUnderFingerByChannel(ETouchIndex::Type FingerIndex, ECollisionChannel Channel, FHitResult& OutHit);
+
+	/// World space ray through the mouse cursor.
+	UFUNCTION(BlueprintCallable, Category = "FineCursorQuery")
+	bool GetCursorRay(FVector& OutOrigin, FVector& OutDirection);
+	/// World space ray through the finger. False while the finger isn't pressed.
+	UFUNCTION(BlueprintCallable, Category = "FineCursorQuery")
+	bool GetFingerRay(ETouchIndex::Type FingerIndex, FVector& OutOrigin, FVector& OutDirection);
+
+	FORCEINLINE ECollisionChannel GetTraceChannel() const { return TraceChannel; }
+
+	static UFineCursorQueryComponent* Get(const AController* Controller);
+
+protected:
+	/// Cursor queries use Source 0, finger queries 1 + finger index.
+	bool GetHitResult(int32 Source, ECollisionChannel Channel, FHitResult& OutHit);
+	bool GetRay(int32 Source, FVector& OutOrigin, FVector& OutDirection);
+	bool GetScreenPosition(int32 Source, FVector2D& OutScreenPosition) const;
+	APlayerController* GetPlayerController() const;
+
+private:
+	/// Default channel for cursor and finger traces, e.g. a dedicated ground channel.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCursorQuery", meta = (AllowPrivateAccess = "true"))
+	TEnumAsByte<ECollisionChannel> TraceChannel = ECC_Visibility;
+
+	/// Trace against complex collision. Simple collision is cheaper when it's accurate enough.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCursorQuery", meta = (AllowPrivateAccess = "true"))
+	bool bTraceComplex = true;
+
+	/// Trace asynchronously and serve the result of the previous frame's trace. A synchronous trace is done only when
+	/// no result of the previous frame is available, e.g. on the first query.
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FineCursorQuery", meta = (AllowPrivateAccess = "true"))
+	bool bAsyncTraces = false;
+
+	struct FCachedHit
+	{
+		uint64 Frame = 0;
+		int32 Source = 0;
+		ECollisionChannel Channel = ECC_Visibility;
+		bool bHit = false;
+		FHitResult Hit;
+		FFineAsyncLineTrace AsyncTrace;
+	};
+
+	struct FCachedRay
+	{
+		uint64 Frame = 0;
+		int32 Source = 0;
+		bool bValid = false;
+		FVector Origin = FVector::ZeroVector;
+		FVector Direction = FVector::ZeroVector;
+	};
+
+	// Only a few sources and channels are queried, so entries are searched linearly and reused across frames.
+	TArray<FCachedHit, TInlineAllocator<2>> CachedHits;
+	TArray<FCachedRay, TInlineAllocator<2>> CachedRays;
+};
@@ -10,6 +10,9 @@
 
 struct FGameplayTag;
 class UFineCharacterGameplay;
+class UFineClickToMoveComponent;
+class UFineCursorEffectComponent;
+class UFineCursorQueryComponent;
 class UAbilitySystemComponent;
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnCursorEffectSpawned, const FVector&, Location);
 
@@ -57,10 +60,13 @@ public:
 	FORCEINLINE const FVector& GetCachedDestination() const { return CachedDestination; }
 
 	virtual void BindCharacterInputEvents();
+	virtual void ReplayInputEvent(EFineInputEvent Event, const FVector3f& Value) override;
 	virtual void UnbindCharacterInputEvents();
 protected:
 	virtual void BeginPlay() override;
-	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
+	                           FActorComponentTickFunction* ThisTickFunction) override;
+
 	/** True if the controlled character should navigate to the mouse cursor. */
 	uint32 bMoveToMouseCursor : 1;
 
@@ -70,6 +76,8 @@ protected:
 	void OnTouchTriggered();
 	void OnTouchReleased();
 	void OnWalkTriggered(const FInputActionInstance& InputActionInstance);
+	/// Walk handler body, also called by input replays.
+	void OnWalkInput(const FVector2D& InputValue);
 	void OnWalkReleased(const FInputActionInstance& InputActionInstance);
 	void OnRunKeyTriggered();
 	void OnRunKeyReleased();
@@ -88,6 +96,19 @@ private:
 	/// User's using touch interface?
 	bool bIsTouch;
 	FVector TouchStart = FVector::ZeroVector;
+
+	/// Movement intents gathered from input events, resolved once per frame. Walk wins over touch, touch over click.
+	enum EMovementIntent : uint8
+	{
+		MovementIntent_None = 0,
+		MovementIntent_Click = 1 << 0,
+		MovementIntent_Touch = 1 << 1,
+		MovementIntent_Walk = 1 << 2,
+	};
+	uint8 PendingMovementIntents = MovementIntent_None;
+	/// Normalized direction of the last walk input in the frame.
+	FVector PendingWalkDirection = FVector::ZeroVector;
+	void ResolveMovementIntents(float DeltaTime);
 	
 	/** Click Input Action */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input, meta=(AllowPrivateAccess = "true"))
@@ -114,11 +135,14 @@ private:
 	int32 JumpActionInputID = INDEX_NONE;
 
 	FTimerHandle RunDisableTimerHandle;
+	/// Cancels running when stamina is depleted, while a character is possessed.
+	int32 RunCancellationRuleID = INDEX_NONE;
+	/// Movement of the possessed character, which ticks after this component.
+	TWeakObjectPtr<UCharacterMovementComponent> DependentCharacterMovement;
 
 	// --------------------
 	// Movement
 	// --------------------
-	FTimerHandle MovementTimerHandle;
 	void UpdateAddMovementInput();
 
 	// --------------------
@@ -126,5 +150,20 @@ private:
 	// --------------------
 	bool IsCharacterRunning();
 	bool IsCharacterJumping();
-	bool GetCursorLocation(FVector& OutLocation) const;
+	bool GetCursorLocation(FVector& OutLocation);
+	/// Shared with other cursor consumers of the owning controller, added if the controller has none.
+	UFineCursorQueryComponent* GetCursorQuery();
+	/// Click to move of the owning controller, added if the controller has none.
+	UFineClickToMoveComponent* GetClickToMove();
+	/// Cursor effect pool of the owning controller, added if the controller has none.
+	UFineCursorEffectComponent* GetCursorEffects();
+
+	UPROPERTY(Transient)
+	TObjectPtr<UFineCursorQueryComponent> CursorQuery;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UFineClickToMoveComponent> ClickToMove;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UFineCursorEffectComponent> CursorEffects;
 };
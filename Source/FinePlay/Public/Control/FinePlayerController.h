@@ -6,6 +6,9 @@
 #include "GameFramework/PlayerController.h"
 #include "FinePlayerController.generated.h"
 
+class UFineClickToMoveComponent;
+class UFineCursorEffectComponent;
+class UFineCursorQueryComponent;
 class UFineMovementInputControl;
 /**
  * Provides a base class for player controllers.
@@ -20,13 +23,27 @@ public:
 
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	virtual void OnPossess(APawn* InPawn) override;
 	virtual void OnUnPossess() override;
+	virtual void ProcessPlayerInput(const float DeltaTime, const bool bGamePaused) override;
 
 	FORCEINLINE UFineMovementInputControl* GetMovementInputControl() const { return MovementInputControl; }
+	FORCEINLINE UFineCursorQueryComponent* GetCursorQuery() const { return CursorQuery; }
+	FORCEINLINE UFineClickToMoveComponent* GetClickToMove() const { return ClickToMove; }
+	FORCEINLINE UFineCursorEffectComponent* GetCursorEffects() const { return CursorEffects; }
 
 private:
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category=InputControl, meta = (AllowPrivateAccess = "true"))
 	UFineMovementInputControl* MovementInputControl;
+
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category=InputControl, meta = (AllowPrivateAccess = "true"))
+	UFineCursorQueryComponent* CursorQuery;
+
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category=InputControl, meta = (AllowPrivateAccess = "true"))
+	UFineClickToMoveComponent* ClickToMove;
+
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category=InputControl, meta = (AllowPrivateAccess = "true"))
+	UFineCursorEffectComponent* CursorEffects;
 };
@@ -0,0 +1,56 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/// Phases of UFineBaseAbility timed while the ability benchmark is recording.
+enum class EFineAbilityPhase : uint8
+{
+	CanActivate,
+	Commit,
+	ApplyEffects,
+	End,
+	Count
+};
+
+namespace FineAbilityBenchmark
+{
+#if WITH_DEV_AUTOMATION_TESTS
+	/// Set by the benchmark while it's measuring. Game thread only.
+	FINEPLAY_API extern bool bRecording;
+
+	FINEPLAY_API void AddPhaseCycles(EFineAbilityPhase Phase, uint64 Cycles);
+
+	/// Times the enclosing scope while the benchmark is recording. Costs a branch otherwise.
+	class FScopedPhase
+	{
+	public:
+		explicit FScopedPhase(const EFineAbilityPhase InPhase)
+			: Phase(InPhase), StartCycles(bRecording ? FPlatformTime::Cycles64() : 0)
+		{
+		}
+
+		~FScopedPhase()
+		{
+			if (StartCycles != 0)
+			{
+				AddPhaseCycles(Phase, FPlatformTime::Cycles64() - StartCycles);
+			}
+		}
+
+	private:
+		EFineAbilityPhase Phase;
+		uint64 StartCycles;
+	};
+#else
+	/// The benchmark is compiled out, so there's nothing to time.
+	class FScopedPhase
+	{
+	public:
+		explicit FScopedPhase(const EFineAbilityPhase)
+		{
+		}
+	};
+#endif
+}
@@ -0,0 +1,48 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+
+class UAbilitySystemComponent;
+
+/**
+ * Records loose gameplay tag traffic per character and tag while FinePlay.TagProfiler.Enable is set: adds, removes,
+ * listener fan-out and time spent dispatching the change, to find chatty tags that cascade into ability blocks.
+ *
+ * Dispatch time covers the whole add or remove, including engine listeners such as ability blocking. Fan-out counts
+ * FinePlay listeners that open a FScopedListener. Use FinePlay.TagProfiler.Dump and FinePlay.TagProfiler.DumpCsv.
+ */
+namespace FineGameplayTagProfiler
+{
+	/// Mirrors FinePlay.TagProfiler.Enable. Game thread only.
+	FINEPLAY_API extern bool bEnabled;
+
+	/// Same as UAbilitySystemComponent::AddLooseGameplayTag, recorded while profiling.
+	FINEPLAY_API void AddLooseTag(UAbilitySystemComponent* AbilitySystem, const FGameplayTag& Tag);
+	/// Same as UAbilitySystemComponent::RemoveLooseGameplayTag, recorded while profiling.
+	FINEPLAY_API void RemoveLooseTag(UAbilitySystemComponent* AbilitySystem, const FGameplayTag& Tag);
+
+	FINEPLAY_API void AddListenerCycles(uint64 Cycles);
+
+	/// Times a tag event callback and counts it towards the fan-out of the change being dispatched.
+	class FScopedListener
+	{
+	public:
+		FScopedListener() : StartCycles(bEnabled ? FPlatformTime::Cycles64() : 0)
+		{
+		}
+
+		~FScopedListener()
+		{
+			if (StartCycles != 0)
+			{
+				AddListenerCycles(FPlatformTime::Cycles64() - StartCycles);
+			}
+		}
+
+	private:
+		uint64 StartCycles;
+	};
+}
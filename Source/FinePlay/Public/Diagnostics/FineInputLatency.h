@@ -0,0 +1,80 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/// Points along the chain from an input event to the pawn responding.
+enum class EFineInputLatencyStage : uint8
+{
+	/// The player controller started processing input for the frame.
+	Event,
+	/// A FinePlay input handler received the action.
+	Handler,
+	/// AddMovementInput, a path following request or PressInputID.
+	Applied,
+	/// The pressed ability activated.
+	Activated,
+	/// First movement update with a nonzero velocity.
+	Motion,
+	Num
+};
+
+/**
+ * Measures input to motion latency per pawn and action while FinePlay.InputLatency.Enable is set.
+ *
+ * A handler begins a chain, which then collects the first time of each later stage. Movement chains end at Motion and
+ * only begin from rest. Ability chains end at Activated. Each stage is recorded in a histogram of milliseconds since the
+ * input event, per action. The last latencies are shown by "stat FinePlay".
+ * Use FinePlay.InputLatency.Dump and FinePlay.InputLatency.DumpCsv.
+ *
+ * Doesn't depend on a viewport, so it also measures input injected in headless automation, e.g. with
+ * UEnhancedInputLocalPlayerSubsystem::InjectInputForAction.
+ */
+namespace FineInputLatency
+{
+	/// Mirrors FinePlay.InputLatency.Enable. Game thread only.
+	FINEPLAY_API extern bool bEnabled;
+
+	/// Latency statistics of one stage of one action.
+	struct FINEPLAY_API FLatencyHistogram
+	{
+		/// Upper bounds of the bins in milliseconds. The last bin has no upper bound.
+		static constexpr double BinBounds[] = {1.0, 2.0, 4.0, 8.0, 16.7, 33.3, 50.0, 66.7, 100.0, 150.0, 250.0, 500.0};
+		static constexpr int32 NumBins = UE_ARRAY_COUNT(BinBounds) + 1;
+
+		uint32 Bins[NumBins] = {};
+		uint32 Count = 0;
+		double SumMs = 0.0;
+		double MinMs = 0.0;
+		double MaxMs = 0.0;
+
+		void Add(double Ms);
+		/// Upper bound of the bin containing the percentile, or MaxMs for the last bin.
+		double GetPercentile(double Percentile) const;
+		FORCEINLINE double GetMean() const { return Count > 0 ? SumMs / Count : 0.0; }
+	};
+
+	/// The controller started processing input. Call before input handlers run.
+	FINEPLAY_API void MarkInputEvent();
+
+	/// A handler received the action for the pawn. Ignored while a chain of the same action is running, and replaces
+	/// the running chain of another action.
+	FINEPLAY_API void BeginChain(const AActor* Pawn, FName Action, bool bEndsAtActivation);
+
+	/// The chain of the pawn reached the stage. Only the first time per chain counts. Chains older than
+	/// FinePlay.InputLatency.Timeout are dropped instead.
+	FINEPLAY_API void Mark(const AActor* Pawn, EFineInputLatencyStage Stage);
+
+	/// The action took no effect, e.g. the ability couldn't activate. Drops the running chain of the pawn if it's of
+	/// the action, or of any action if none is given.
+	FINEPLAY_API void CancelChain(const AActor* Pawn, FName Action = NAME_None);
+
+	/// Histogram of the stage of the action, e.g. for automation tests. Null if nothing was recorded.
+	FINEPLAY_API const FLatencyHistogram* FindHistogram(FName Action, EFineInputLatencyStage Stage);
+
+	/// Chains that didn't end within FinePlay.InputLatency.Timeout.
+	FINEPLAY_API uint32 GetTimedOutChains();
+
+	FINEPLAY_API void Reset();
+}
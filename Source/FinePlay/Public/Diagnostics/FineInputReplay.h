@@ -0,0 +1,74 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class APlayerController;
+class UActorComponent;
+
+/// Input handler calls of FinePlay input controls, as recorded by FineInputReplay.
+enum class EFineInputEvent : uint8
+{
+	InputStarted,
+	SetDestinationTriggered,
+	SetDestinationReleased,
+	TouchTriggered,
+	TouchReleased,
+	/// Value holds the 2D input value.
+	WalkTriggered,
+	RunTriggered,
+	RunReleased,
+	JumpTriggered,
+	JumpReleased,
+	InteractTriggered,
+	InteractReleased,
+	/// Value holds the location under the cursor or finger.
+	CursorHit,
+	CursorMiss,
+};
+
+/**
+ * Records the input of a FinePlay player controller at handler level and replays it, to profile identical sessions
+ * across builds, e.g. headless with -nullrhi.
+ *
+ * A recording holds the frame deltas, the handler calls of each frame with their values, and the cursor hit locations
+ * that the handlers used. Replays call the same handlers with the same values in the same frames, and serve the
+ * recorded cursor hits instead of tracing. Frame deltas are replayed with a fixed time step. Live input is ignored
+ * while replaying.
+ *
+ * Use FinePlay.Input.Record, FinePlay.Input.StopRecording and FinePlay.Input.Replay, or start with
+ * -FinePlayRecord=<path> or -FinePlayReplay=<path>. A replay started from the command line exits when done.
+ */
+namespace FineInputReplay
+{
+	/// Called by the player controller before it processes input. True if the frame's input was replayed, in which
+	/// case live input should be skipped.
+	FINEPLAY_API bool TickFrame(APlayerController* Controller, float DeltaTime);
+
+	/// Stops recording or replaying for the controller, e.g. when it ends play. Writes a pending recording.
+	FINEPLAY_API void StopController(const APlayerController* Controller);
+
+	FINEPLAY_API bool IsRecording();
+	FINEPLAY_API bool IsReplaying();
+
+	FINEPLAY_API void RecordEvent(const UActorComponent* Control, EFineInputEvent Event, const FVector3f& Value);
+
+	/// Records the cursor location a handler of the control used.
+	FINEPLAY_API void RecordCursorLocation(const UActorComponent* Control, bool bHit, const FVector& Location);
+
+	/// The next recorded cursor location of the frame, while replaying. False if not replaying the control.
+	FINEPLAY_API bool ConsumeCursorLocation(const UActorComponent* Control, bool& bOutHit, FVector& OutLocation);
+
+	/// Records a handler call, unless it's called from another recorded handler, which replays call as well.
+	class FINEPLAY_API FScopedHandler
+	{
+	public:
+		FScopedHandler(const UActorComponent* Control, EFineInputEvent Event,
+		               const FVector3f& Value = FVector3f::ZeroVector);
+		~FScopedHandler();
+
+	private:
+		static int32 Depth;
+	};
+}
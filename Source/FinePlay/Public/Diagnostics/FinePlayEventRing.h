@@ -0,0 +1,52 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+#ifndef FINEPLAY_WITH_EVENT_RING
+#define FINEPLAY_WITH_EVENT_RING !UE_BUILD_SHIPPING
+#endif
+
+/**
+ * Fixed size in-memory record of high frequency events, e.g. ability activation checks and input triggers.
+ *
+ * Recording is lock-free and formats nothing: an entry keeps a static description, a name and a value. Entries are
+ * formatted only when dumped with FinePlay.Log.DumpEvents. The oldest entries are overwritten.
+ */
+class FINEPLAY_API FFinePlayEventRing
+{
+public:
+	static constexpr uint32 Capacity = 4096;
+
+	struct FEntry
+	{
+		/// Index + 1 once written, 0 while being written.
+		std::atomic<uint64> Sequence{0};
+		uint64 Cycles = 0;
+		/// String literal.
+		const TCHAR* Event = nullptr;
+		FName Name;
+		double Value = 0.0;
+		uint32 ThreadId = 0;
+	};
+
+	static FFinePlayEventRing& Get();
+
+	/// Any thread. Event must be a string literal.
+	void Record(const TCHAR* Event, const FName& Name = NAME_None, double Value = 0.0);
+
+	/// Writes the last Count events to the log, oldest first.
+	void Dump(int32 Count = Capacity) const;
+
+private:
+	FEntry Entries[Capacity];
+	std::atomic<uint64> Head{0};
+};
+
+#if FINEPLAY_WITH_EVENT_RING
+#define FP_RECORD_EVENT(EVENT, ...) FFinePlayEventRing::Get().Record(TEXT(EVENT), ##__VA_ARGS__)
+#else
+#define FP_RECORD_EVENT(EVENT, ...)
+#endif
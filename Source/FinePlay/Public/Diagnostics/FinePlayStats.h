@@ -0,0 +1,64 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/**
+ * FinePlay stats group ("stat FinePlay") and Unreal Insights channel ("-trace=cpu,FinePlay").
+ *
+ * Cycle stats time the hot paths; the DWORD counters are cleared every frame, so they read as calls per frame. The
+ * input latency stats keep the last measured latency, see FineInputLatency.
+ */
+DECLARE_STATS_GROUP(TEXT("FinePlay"), STATGROUP_FinePlay, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Scene Transition"), STAT_FinePlay_SceneTransition, STATGROUP_FinePlay, FINEPLAY_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Database Lookup"), STAT_FinePlay_DatabaseLookup, STATGROUP_FinePlay, FINEPLAY_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ability Grant"), STAT_FinePlay_AbilityGrant, STATGROUP_FinePlay, FINEPLAY_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ability Activation"), STAT_FinePlay_AbilityActivation, STATGROUP_FinePlay,
+                          FINEPLAY_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Movement Input"), STAT_FinePlay_MovementInput, STATGROUP_FinePlay, FINEPLAY_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Cursor Trace"), STAT_FinePlay_CursorTrace, STATGROUP_FinePlay, FINEPLAY_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Animation Update"), STAT_FinePlay_AnimationUpdate, STATGROUP_FinePlay, FINEPLAY_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("MPC Update"), STAT_FinePlay_MPCUpdate, STATGROUP_FinePlay, FINEPLAY_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Resource Regen"), STAT_FinePlay_ResourceRegen, STATGROUP_FinePlay, FINEPLAY_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Scene Transitions"), STAT_FinePlay_SceneTransitionCalls, STATGROUP_FinePlay,
+                                  FINEPLAY_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Database Lookups"), STAT_FinePlay_DatabaseLookupCalls, STATGROUP_FinePlay,
+                                  FINEPLAY_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ability Grants"), STAT_FinePlay_AbilityGrantCalls, STATGROUP_FinePlay,
+                                  FINEPLAY_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ability Activations"), STAT_FinePlay_AbilityActivationCalls,
+                                  STATGROUP_FinePlay, FINEPLAY_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Movement Inputs"), STAT_FinePlay_MovementInputCalls, STATGROUP_FinePlay,
+                                  FINEPLAY_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Cursor Traces"), STAT_FinePlay_CursorTraceCalls, STATGROUP_FinePlay,
+                                  FINEPLAY_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Animation Updates"), STAT_FinePlay_AnimationUpdateCalls, STATGROUP_FinePlay,
+                                  FINEPLAY_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("MPC Updates"), STAT_FinePlay_MPCUpdateCalls, STATGROUP_FinePlay,
+                                  FINEPLAY_API);
+
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Input To Handler (ms)"), STAT_FinePlay_InputToHandler, STATGROUP_FinePlay,
+                                      FINEPLAY_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Input To Applied (ms)"), STAT_FinePlay_InputToApplied, STATGROUP_FinePlay,
+                                      FINEPLAY_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Input To Activation (ms)"), STAT_FinePlay_InputToActivation,
+                                      STATGROUP_FinePlay, FINEPLAY_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Input To Motion (ms)"), STAT_FinePlay_InputToMotion, STATGROUP_FinePlay,
+                                      FINEPLAY_API);
+
+UE_TRACE_CHANNEL_EXTERN(FinePlayChannel, FINEPLAY_API);
+
+/// Times the enclosing scope under the cycle stat and as an Insights CPU event on FinePlayChannel.
+#define FP_SCOPE_CYCLE(Stat) \
+	SCOPE_CYCLE_COUNTER(STAT_FinePlay_##Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("FinePlay::" #Stat, FinePlayChannel)
+
+/// FP_SCOPE_CYCLE plus one call on the matching per frame counter.
+#define FP_SCOPE_CALL(Stat) \
+	INC_DWORD_STAT(STAT_FinePlay_##Stat##Calls); \
+	FP_SCOPE_CYCLE(Stat)
@@ -0,0 +1,23 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NativeGameplayTags.h"
+
+/**
+ * Gameplay tags used by FinePlay. They are registered natively when the module is loaded, so code can use them
+ * without looking tags up by name at runtime.
+ */
+namespace FinePlayGameplayTags
+{
+	FINEPLAY_API UE_DECLARE_GAMEPLAY_TAG_EXTERN(Actor_State_Alive);
+	FINEPLAY_API UE_DECLARE_GAMEPLAY_TAG_EXTERN(Actor_State_Invincible);
+	FINEPLAY_API UE_DECLARE_GAMEPLAY_TAG_EXTERN(Actor_State_Moving);
+	FINEPLAY_API UE_DECLARE_GAMEPLAY_TAG_EXTERN(Actor_State_Running);
+	FINEPLAY_API UE_DECLARE_GAMEPLAY_TAG_EXTERN(Actor_State_Jumping);
+	FINEPLAY_API UE_DECLARE_GAMEPLAY_TAG_EXTERN(Actor_State_Exhausted);
+
+	/// Returns the native tag if the name matches it, otherwise requests the tag by name.
+	FINEPLAY_API FGameplayTag ResolveTag(const FName& TagName, const FGameplayTag& NativeTag);
+}
@@ -5,12 +5,61 @@
 #include "CoreMinimal.h"
 #include "FineBaseLoggerMacros.h"
 
-DECLARE_LOG_CATEGORY_EXTERN(LogFinePlay, Log, All);
+// Highest verbosity compiled into each FinePlay category. Shipping builds keep warnings and errors only. Define these
+// in the target to change them, e.g. FINEPLAY_ABILITY_LOG_CEILING=Verbose.
+#ifndef FINEPLAY_LOG_CEILING
+#if UE_BUILD_SHIPPING
+#define FINEPLAY_LOG_CEILING Warning
+#else
+#define FINEPLAY_LOG_CEILING All
+#endif
+#endif
+#ifndef FINEPLAY_ABILITY_LOG_CEILING
+#define FINEPLAY_ABILITY_LOG_CEILING FINEPLAY_LOG_CEILING
+#endif
+#ifndef FINEPLAY_ATTRIBUTE_LOG_CEILING
+#define FINEPLAY_ATTRIBUTE_LOG_CEILING FINEPLAY_LOG_CEILING
+#endif
+#ifndef FINEPLAY_INPUT_LOG_CEILING
+#define FINEPLAY_INPUT_LOG_CEILING FINEPLAY_LOG_CEILING
+#endif
+
+DECLARE_LOG_CATEGORY_EXTERN(LogFinePlay, Log, FINEPLAY_LOG_CEILING);
+DECLARE_LOG_CATEGORY_EXTERN(LogFinePlayAbility, Log, FINEPLAY_ABILITY_LOG_CEILING);
+DECLARE_LOG_CATEGORY_EXTERN(LogFinePlayAttribute, Log, FINEPLAY_ATTRIBUTE_LOG_CEILING);
+DECLARE_LOG_CATEGORY_EXTERN(LogFinePlayInput, Log, FINEPLAY_INPUT_LOG_CEILING);
+
+/// Compiles out above the category's ceiling, and evaluates the arguments only if the category logs the verbosity.
+#define FP_GATED_LOG(CATEGORY, VERBOSITY, LOGGER, FORMAT, ...) \
+	do \
+	{ \
+		if (UE_LOG_ACTIVE(CATEGORY, VERBOSITY)) \
+		{ \
+			LOGGER(CATEGORY, FORMAT, ##__VA_ARGS__); \
+		} \
+	} \
+	while (false)
+
+#define FP_CATEGORY_ERROR(CATEGORY, FORMAT, ...) FP_GATED_LOG(CATEGORY, Error, FINEBASE_ERROR, FORMAT, ##__VA_ARGS__)
+#define FP_CATEGORY_WARNING(CATEGORY, FORMAT, ...) FP_GATED_LOG(CATEGORY, Warning, FINEBASE_WARNING, FORMAT, ##__VA_ARGS__)
+#define FP_CATEGORY_DISPLAY(CATEGORY, FORMAT, ...) FP_GATED_LOG(CATEGORY, Display, FINEBASE_DISPLAY, FORMAT, ##__VA_ARGS__)
+#define FP_CATEGORY_LOG(CATEGORY, FORMAT, ...) FP_GATED_LOG(CATEGORY, Log, FINEBASE_LOG, FORMAT, ##__VA_ARGS__)
+#define FP_CATEGORY_VERBOSE(CATEGORY, FORMAT, ...) FP_GATED_LOG(CATEGORY, Verbose, FINEBASE_VERBOSE, FORMAT, ##__VA_ARGS__)
+#define FP_CATEGORY_VERYVERBOSE(CATEGORY, FORMAT, ...) \
+	FP_GATED_LOG(CATEGORY, VeryVerbose, FINEBASE_VERYVERBOSE, FORMAT, ##__VA_ARGS__)
 
 #define FP_FATAL(FORMAT, ...) FINEBASE_FATAL(LogFinePlay, FORMAT, ##__VA_ARGS__)
-#define FP_ERROR(FORMAT, ...) FINEBASE_ERROR(LogFinePlay, FORMAT, ##__VA_ARGS__)
-#define FP_WARNING(FORMAT, ...) FINEBASE_WARNING(LogFinePlay, FORMAT, ##__VA_ARGS__)
-#define FP_DISPLAY(FORMAT, ...) FINEBASE_DISPLAY(LogFinePlay, FORMAT, ##__VA_ARGS__)
-#define FP_LOG(FORMAT, ...) FINEBASE_LOG(LogFinePlay, FORMAT, ##__VA_ARGS__)
-#define FP_VERBOSE(FORMAT, ...) FINEBASE_VERBOSE(LogFinePlay, FORMAT, ##__VA_ARGS__)
-#define FP_VERYVERBOSE(FORMAT, ...) FINEBASE_VERYVERBOSE(LogFinePlay, FORMAT, ##__VA_ARGS__)
+#define FP_ERROR(FORMAT, ...) FP_CATEGORY_ERROR(LogFinePlay, FORMAT, ##__VA_ARGS__)
+#define FP_WARNING(FORMAT, ...) FP_CATEGORY_WARNING(LogFinePlay, FORMAT, ##__VA_ARGS__)
+#define FP_DISPLAY(FORMAT, ...) FP_CATEGORY_DISPLAY(LogFinePlay, FORMAT, ##__VA_ARGS__)
+#define FP_LOG(FORMAT, ...) FP_CATEGORY_LOG(LogFinePlay, FORMAT, ##__VA_ARGS__)
+#define FP_VERBOSE(FORMAT, ...) FP_CATEGORY_VERBOSE(LogFinePlay, FORMAT, ##__VA_ARGS__)
+#define FP_VERYVERBOSE(FORMAT, ...) FP_CATEGORY_VERYVERBOSE(LogFinePlay, FORMAT, ##__VA_ARGS__)
+
+// Hot path subsystems.
+#define FP_ABILITY_LOG(FORMAT, ...) FP_CATEGORY_LOG(LogFinePlayAbility, FORMAT, ##__VA_ARGS__)
+#define FP_ABILITY_VERBOSE(FORMAT, ...) FP_CATEGORY_VERBOSE(LogFinePlayAbility, FORMAT, ##__VA_ARGS__)
+#define FP_ATTRIBUTE_LOG(FORMAT, ...) FP_CATEGORY_LOG(LogFinePlayAttribute, FORMAT, ##__VA_ARGS__)
+#define FP_ATTRIBUTE_VERBOSE(FORMAT, ...) FP_CATEGORY_VERBOSE(LogFinePlayAttribute, FORMAT, ##__VA_ARGS__)
+#define FP_INPUT_LOG(FORMAT, ...) FP_CATEGORY_LOG(LogFinePlayInput, FORMAT, ##__VA_ARGS__)
+#define FP_INPUT_VERBOSE(FORMAT, ...) FP_CATEGORY_VERBOSE(LogFinePlayInput, FORMAT, ##__VA_ARGS__)
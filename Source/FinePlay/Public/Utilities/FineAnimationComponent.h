@@ -61,6 +61,8 @@ protected:
 	FTimerHandle AnimTimerHandle;
 
 private:
+	void OnAnimationTimer();
+
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FinePlay", meta = (AllowPrivateAccess = "true"))
 	float Interval = 1.f / 30.f;
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "FinePlay", meta = (AllowPrivateAccess = "true"))
@@ -0,0 +1,35 @@
+﻿// (c) 2023 Pururum LLC. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+#include "Engine/HitResult.h"
+#include "WorldCollision.h"
+
+/**
+ * Single line trace run by the world's async trace tasks instead of on the game thread.
+ *
+ * A trace requested in frame N can be consumed from frame N + 1. Consume before Request each frame, and fall back to a
+ * synchronous trace when nothing fresh is available, e.g. for the first query.
+ */
+struct FINEPLAY_API FFineAsyncLineTrace
+{
+	/// Issues the trace, at most once per frame.
+	void Request(UWorld* World, const FVector& Start, const FVector& End, ECollisionChannel Channel,
+	             const FCollisionQueryParams& Params);
+
+	/// Latest finished result requested at most MaxAge frames ago. False if there is none.
+	bool Consume(const UWorld* World, FHitResult& OutHit, bool& bOutHit, uint64 MaxAge = 1);
+
+	void Reset();
+
+private:
+	FTraceHandle PendingHandle;
+	uint64 PendingFrame = 0;
+
+	FHitResult Hit;
+	bool bHit = false;
+	bool bHasResult = false;
+	uint64 ResultFrame = 0;
+};
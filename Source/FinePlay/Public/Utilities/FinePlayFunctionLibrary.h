@@ -3,10 +3,13 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "GameplayEffectTypes.h"
 #include "UObject/Object.h"
 #include "FinePlayFunctionLibrary.generated.h"
 
+class UAbilitySystemComponent;
 class UFineSceneLoop;
+class UGameplayEffect;
 /**
  * A set of utility functions for fine play module.
  */
@@ -30,4 +33,20 @@ public:
 
 	UFUNCTION(BlueprintCallable, Category = "FinePlay")
 	static bool GetUserInputEnabled(AActor* Actor);
+
+	/// Builds one spec of the effect and applies it to all targets, e.g. for area damage. Returns the number of targets
+	/// the effect was applied to.
+	UFUNCTION(BlueprintCallable, Category = "FinePlay")
+	static int32 ApplyGameplayEffectToTargets(UAbilitySystemComponent* SourceAbilitySystem,
+	                                          TSubclassOf<UGameplayEffect> EffectClass, float Level,
+	                                          const TArray<AActor*>& Targets,
+	                                          bool bSkipDeadOrInvincible = false);
+
+	/// Applies the same spec and effect context to all targets. With bSkipDeadOrInvincible, e.g. for damage, dead and
+	/// invincible characters are skipped using their state flags. Returns the number of targets the effect was applied
+	/// to.
+	UFUNCTION(BlueprintCallable, Category = "FinePlay")
+	static int32 ApplyGameplayEffectSpecToTargets(const FGameplayEffectSpecHandle& SpecHandle,
+	                                              const TArray<AActor*>& Targets,
+	                                              bool bSkipDeadOrInvincible = false);
 };